@@ -26,10 +26,8 @@
 #undef ECHO_INPUT
 #define ECHO_INPUT // 9term wants echo
 
-#define DEBUG_PARSE_ECHO
-#undef DEBUG_PARSE_ECHO
-
-# define SERIAL_LOCAL_C Serial  // Or Serial1  for the usart
+# define SERIAL_PORT Serial      // Or Serial1  for the usart
+# define SERIAL_LOCAL_C console // SERIAL_PORT, its output gathered up
 
 // - - - -   snippet   - - - -
 
@@ -46,7 +44,8 @@
 
 */
 
-extern void _dumpRAM(void);
+extern void _HDUMP(void); // dumpram.cpp
+extern void _RDUMP(void);
 extern void _getOneByteRAM(void); // ( addr -- )
 extern void cpMem2Str(void);
 extern void parseStr(void);
@@ -73,24 +72,59 @@ extern void _PINMODE(void);
 */
 #include <SdFat.h> // 'File'
 
-// 0x1200 == 4608 decimal
-
-// #define RAM_SIZE 0x1200
-#define RAM_SIZE 0x1200 // Feather M0 Express - program would not compile using 0x4800 - compiler complained about running out of .. memory of some sort
-// #define RAM_SIZE 0x4800 // ~ 18 kb
-#define S0 0x1000
-#define R0 0x0f00
-#define NAME(m, f, c, x, y, z) {memory.data [m] = f + c + (x << 8) + (y << 16) + (z << 24);}
-#define LINK(m, a) {memory.data [m] = a;}
-#define CODE(m, a) {memory.program [m] = a;}
-#define DATA(m, a) {memory.data [m] = a;}
+#include "vm.h" // RAM_SIZE S0 R0, cells and function pointers
+
 #define IMMED 0x80
+#define NAME_CELL(x) ((x) & ~IMMED) // a name cell less the flag, as _WORD makes one
 
 #include "prequel.h"
 #include "compatibility.h"
 
 #include "common.h"
 
+// console output: what the words print is gathered in tx_buf []
+// and handed to the port a buffer at a time - at cr, when it fills,
+// before the keyboard is waited on, and at flush.  Over USB CDC
+// each write is a transfer of its own.  Input is the port's.
+#define TX_SIZE 256
+class Console : public Print {
+public:
+  int available (void) { return SERIAL_PORT.available (); }
+  int read (void) { return SERIAL_PORT.read (); }
+
+  using Print::write;
+  size_t write (uint8_t c) {
+    tx_buf [tx_len++] = c;
+    if (tx_len >= TX_SIZE) flush ();
+    return 1;
+  }
+  size_t write (const uint8_t *b, size_t n) {
+    if (n >= (size_t) (TX_SIZE - tx_len)) flush (); // never left full
+    if (n >= TX_SIZE) return SERIAL_PORT.write (b, n); // a long one goes as it is
+    memcpy (tx_buf + tx_len, b, n);
+    tx_len += n;
+    return n;
+  }
+  void flush (void) {
+    if (tx_len) SERIAL_PORT.write (tx_buf, tx_len);
+    tx_len = 0;
+  }
+
+private:
+  uint8_t tx_buf [TX_SIZE];
+  int tx_len = 0;
+};
+Console console;
+Print *console_out = &console; // for src/ files that print
+
+#ifdef HOST_NATIVE
+#include "native.h" // host/: colon definitions as x86-64 code
+#else
+#define NATIVE_STORED(a)
+#define NATIVE_STORED_CELLS(a, z)
+#define NATIVE_NESTED 0
+#endif // #ifdef HOST_NATIVE
+
 #define LINE_ENDING 10
 #define ALT_LINE_ENDING 13
 
@@ -108,26 +142,163 @@ extern void flash_setup(void); // flash_ops.cpp
 extern File thisFile; // You must include SdFat.h to use 'File' here
 
 // global variables
-union Memory {
-  int data [RAM_SIZE];
-  void (*program [0]) (void);
-} memory;
-
-int PKF = 0; // Peek Flag set to false initially
-String tib = "";
-int S = S0; // data stack pointer
-int R = R0; // return stack pointer
-int I = 0; // instruction pointer
-int W = 0; // working register
-int T = 0; // top of stack
+struct Memory memory;
+
+// terminal input buffer: the line typed, or the token from a
+// file.  Nothing here is allocated - a line too long for it comes
+// in pieces.
+#define TIB_SIZE 256
+char tib [TIB_SIZE];
+int tib_len = 0; // #tib, bytes in tib
+int tib_in = 0;  // >in, bytes of tib parsed
+int tib_tok = 0; // where the token last parsed starts - it ends
+                 // with the char before >in, the one that ended it
+#define TOKEN     (tib + tib_tok)
+#define TOKEN_LEN (tib_in - tib_tok - 1)
+#define TIB_END   (tib [tib_in ? (tib_in - 1) : 0]) // the char that ended the token
+
+// keyboard input: the serial port is drained into rx_ring [] when
+// key or parse find nothing left to read, and parse takes a whole
+// line from there into tib at once.  The Arduino core's own buffer
+// (filled by the USB or SERCOM interrupt) only has to hold what
+// comes in while a line runs.  Counters, not indexes: rx_head is
+// bytes ever put in, rx_tail bytes taken out, rx_echo bytes echoed.
+#ifdef HOST_BUILD
+#define RX_SIZE 4096
+#else
+#define RX_SIZE 1024
+#endif // #ifdef HOST_BUILD
+#define RX_MASK (RX_SIZE - 1)
+static char rx_ring [RX_SIZE];
+static unsigned int rx_head = 0, rx_tail = 0, rx_echo = 0;
+static int rx_lines = 0; // line ends between rx_tail and rx_head
+
+#define RX_EOL(c) (((c) == LINE_ENDING) || ((c) == ALT_LINE_ENDING))
+
+static void rx_echo_to (unsigned int to) {
+#ifdef ECHO_INPUT
+  while (rx_echo != to) {
+    unsigned int at = rx_echo & RX_MASK;
+    unsigned int n = to - rx_echo;
+    if (n > (RX_SIZE - at)) n = RX_SIZE - at;
+    SERIAL_LOCAL_C.write ((const uint8_t *) &rx_ring [at], n);
+    rx_echo += n;
+  }
+#endif
+  rx_echo = to;
+}
+
+// what the port has now, as far as the ring holds.  For parse
+// (line true) a backspace or delete takes back the last char of
+// a line not yet ended, and while no line is ended what came in is
+// echoed as it is typed; a line after one that is ended is echoed
+// when parse takes it.  key has its chars as they come, unechoed.
+static void rx_poll (boolean line) {
+  SERIAL_LOCAL_C.flush (); // what was printed goes out before the wait
+  int n = SERIAL_LOCAL_C.available ();
+  while ((n-- > 0) && ((rx_head - rx_tail) < RX_SIZE)) {
+    char c = SERIAL_LOCAL_C.read ();
+    if (line && ((c == 8) || (c == 127))) {
+      if ((rx_head == rx_tail) || RX_EOL (rx_ring [(rx_head - 1) & RX_MASK])) continue;
+      rx_head--;
+      if ((int) (rx_echo - rx_head) > 0) {
+        rx_echo = rx_head;
+#ifdef ECHO_INPUT
+        SERIAL_LOCAL_C.print ("\b \b");
+#endif
+      }
+      continue;
+    }
+    rx_ring [rx_head++ & RX_MASK] = c;
+    if (RX_EOL (c)) rx_lines++;
+  }
+  if (line && !rx_lines) {
+    rx_echo_to (rx_head);
+    SERIAL_LOCAL_C.flush ();
+  }
+}
+
+static int rx_getc (void) {
+  char c = rx_ring [rx_tail++ & RX_MASK];
+  if (RX_EOL (c)) rx_lines--;
+  if ((int) (rx_tail - rx_echo) > 0) rx_echo = rx_tail;
+  return (unsigned char) c;
+}
+
+// a line to take: one ended, or as much as tib holds, or a full ring
+static boolean rx_line_ready (void) {
+  return rx_lines || ((rx_head - rx_tail) >= TIB_SIZE);
+}
+
+// the next line, into tib: up to and with its line end, or cut
+// after the last blank that fits, so no token is split.  A token
+// longer than LEX_TOKEN_MAX is cut.  Echoed, as far as it was not
+static void rx_line (void) {
+  unsigned int at = rx_tail, cut_at = rx_tail;
+  int n = 0, cut = 0, run = 0;
+  boolean ended = false;
+  while ((at != rx_head) && (n < (TIB_SIZE - 1))) {
+    char c = rx_ring [at++ & RX_MASK];
+    if (c > ' ') {
+      if (run++ >= LEX_TOKEN_MAX) continue;
+    } else {
+      run = 0;
+      cut = n + 1;
+      cut_at = at;
+    }
+    tib [n++] = c;
+    if (RX_EOL (c)) {
+      ended = true;
+      rx_lines--;
+      break;
+    }
+  }
+  if (!ended) {
+    if (cut) {
+      n = cut;
+      at = cut_at;
+    } else {
+      tib [n++] = ' '; // one token, the whole of it
+    }
+  }
+  if ((int) (at - rx_echo) > 0) rx_echo_to (at);
+  rx_tail = at;
+  tib_len = n;
+  tib_in = 0;
+}
+
+void rx_reset (void) {
+  rx_head = rx_tail = rx_echo = 0;
+  rx_lines = 0;
+  tib_tok = tib_len = tib_in = 0;
+}
+
+// a key is there to read: from the ring, or the port
+boolean key_ready (void) {
+  if (rx_head == rx_tail) rx_poll (false);
+  return (rx_head != rx_tail);
+}
+
+struct VM vm = { S0, R0, 0, 0, 0 }; // S R I W T - see vm.h
 int H = 0; // dictionary pointer, HERE
 int D = 0; // dictionary list entry point
 int base = 10;
 boolean state = false; // compiling or not
 boolean keyboard_not_file = true; // keyboard or file input, for parsing
+boolean io_yield = false; // set by words that waited on the keyboard - vm_run returns
+int fuse_at [2] = { -1, -1 }; // last two instructions _COMPILE laid down
+int fuse_h = -1; // H just past them - anything else moves H, or resets this
+int leave_list = 0; // leave operands of the loop being compiled, chained through them
+unsigned short dict_slot [DICT_SLOTS]; // header addresses by name - 0 is empty
+int dict_used = 0; // slots in use
+int dict_spilled = 0; // names left out of a full index - _FIND walks the links for a miss
+boolean dict_indexed = true; // false: _FIND walks the links anyway (bench)
 
 /*  A word in the dictionary has these fields:
-  name  32b word,  a 32 bit int, made up of byte count and three letters
+  name  32b word,  a 32 bit int: byte count (low 7 bits), the IMMED
+        flag, and a 24 bit hash of the name above them.  The letters
+        are packed in the cells below it, or, for a kernel word, kept
+        in kernel_names []
   link  32b word, point to next word in list, 0 says end of list
   code  32b word, a pointer to some actual C compiled code,
         all native code is in this field
@@ -152,7 +323,16 @@ void _NOP (void) {
 
 void _FLOAD (void) { // file load: fload
   SERIAL_LOCAL_C.println(" loading a forth program from flashROM ..");
-     I = 190; //  simulate 'quit'  - does not clear the stack. I = 83 (abort) does.
+  seg_begin (base); // src/image.cpp
+  if (seg_load (&base)) { // compiled before, onto this same dictionary
+    thisFile.close();
+    lex_reset();
+    SERIAL_LOCAL_C.println(" " FILE_NAME " unchanged - " SEGMENT_NAME " put back");
+    keyboard_not_file = true;
+    vm.I = K_quit_loop; // the keyboard's quit loop, as at the end of the file
+    return;
+  }
+     vm.I = K_flquit_loop; //  simulate 'quit'  - does not clear the stack. I = K_abort does.
 }
 
 void _WAGDS (void) { // 'wag' the dotStar colored lED - ItsyBitsy M4, others
@@ -162,53 +342,68 @@ void _WAGDS (void) { // 'wag' the dotStar colored lED - ItsyBitsy M4, others
 }
 
 void _WIGGLE (void) { // toggle dotStar a number of times
-  for (int i = T; i > 0; i--) {
+  for (int i = vm.T; i > 0; i--) {
     _WAGDS();
   }
   _DROP ();
 }
 
 void _EXIT (void) {
-  I = memory.data [R++];
+  PROF_EXIT (vm.R);
+  vm.I = memory.data [vm.R++];
 }
 
 void _DROP (void) {
-  T = memory.data [S++];
+  vm.T = memory.data [vm.S++];
 }
 
 void _DUP (void) {
-  memory.data [--S] = T;
+  memory.data [--vm.S] = vm.T;
 }
 
 void _QDUP (void) {
-  if (T) _DUP ();
+  if (vm.T) _DUP ();
 }
 
 void _KEY (void) {
+  if (!key_ready ()) {
+    key_wait (); // the other tasks run, and key again
+    return;
+  }
   _DUP ();
-  while (!SERIAL_LOCAL_C.available ());
-  T = SERIAL_LOCAL_C.read ();
+  vm.T = rx_getc ();
+  io_yield = true;
 //  SERIAL_LOCAL_C.write (T);
 }
 
+void _KEYQ (void) { // key? ( - f)
+  _DUP ();
+  vm.T = key_ready () ? -1 : 0;
+}
+
 void _EMIT (void) {
-  char c = T;
+  char c = vm.T;
   SERIAL_LOCAL_C.write (c);
   _DROP ();
 }
 
 void _CR (void) {
   SERIAL_LOCAL_C.println (" ");
+  SERIAL_LOCAL_C.flush ();
+}
+
+void _FLUSH (void) {
+  SERIAL_LOCAL_C.flush ();
 }
 
 void _OK (void) {
 #ifdef OLD_OK_HANDLER
-  if (tib [tib.length () - 1] == LINE_ENDING) SERIAL_LOCAL_C.println (" Ok");
+  if (TIB_END == LINE_ENDING) SERIAL_LOCAL_C.println (" Ok");
 #else // default: use new OK handler:
   if ((
-          tib [tib.length () - 1] == LINE_ENDING
+          TIB_END == LINE_ENDING
       ) || (
-          tib [tib.length () - 1] == ALT_LINE_ENDING
+          TIB_END == ALT_LINE_ENDING
       )) SERIAL_LOCAL_C.println (" Ok");
 #endif
 }
@@ -221,6 +416,11 @@ void _WARM (void) {
   NVIC_SystemReset();      // processor software reset
 }
 
+void _SAVEIMAGE (void) { // the dictionary, for the next boot - src/image.cpp
+  if (image_save ()) SERIAL_LOCAL_C.print (" image saved ");
+  else SERIAL_LOCAL_C.print (" image NOT saved ");
+}
+
 void _COPYMEM (void) {
   // in_the_parse_file
   cpMem2Str(); // ( addr ln -- )
@@ -230,32 +430,31 @@ void _COPYMEM (void) {
 void _COMPOSE (void) {
   int counter = 0;
   while(counter < (OUCH)) {
-    int tk = ' ';
     counter++;
-    _KEY();
+    _DUP();
+    vm.T = parse_char(); // from tib, where the line was echoed as it came in
+    if ((vm.T < 0) || (vm.T == '\r') || (vm.T == '\n')) vm.T = ' '; // the line's end ends it
     if (counter > (OUCH - 1)) {
         _DUP();
         SERIAL_LOCAL_C.print(" ERROR INPUT > ");
         SERIAL_LOCAL_C.print((OUCH - 2)); // 30 chars - one for allot header and one for null terminator
         SERIAL_LOCAL_C.print("chars ");
-        T = 43;
+        vm.T = 43;
         _EMIT();
         break;
     }
     // _SPACE(); _DUP(); _HDOT(); _SPACE();
-    if (T == 1) SERIAL_LOCAL_C.print(" Ctrl+A pressed ");
-    if (T == 2) SERIAL_LOCAL_C.print(" Ctrl+B pressed ");
-    if (T == 7) SERIAL_LOCAL_C.print(" Ctrl+G BELL pressed ");
-    if (T == 8) SERIAL_LOCAL_C.print(" Ctrl+H BACKSPACE pressed ");
-    if (T == 15) SERIAL_LOCAL_C.print(" Ctrl+O pressed ");
-    if (T == 27) SERIAL_LOCAL_C.print(" ESC pressed ");
-    if (T == 127) SERIAL_LOCAL_C.print(" RUBOUT pressed (0x7f) ");
-    _DUP();
-    _EMIT();
+    if (vm.T == 1) SERIAL_LOCAL_C.print(" Ctrl+A pressed ");
+    if (vm.T == 2) SERIAL_LOCAL_C.print(" Ctrl+B pressed ");
+    if (vm.T == 7) SERIAL_LOCAL_C.print(" Ctrl+G BELL pressed ");
+    if (vm.T == 8) SERIAL_LOCAL_C.print(" Ctrl+H BACKSPACE pressed ");
+    if (vm.T == 15) SERIAL_LOCAL_C.print(" Ctrl+O pressed ");
+    if (vm.T == 27) SERIAL_LOCAL_C.print(" ESC pressed ");
+    if (vm.T == 127) SERIAL_LOCAL_C.print(" RUBOUT pressed (0x7f) ");
     _SWAP(); // risk of underflow
     _OVER();
     // DEBUG: // Serial.print("Tee is: "); Serial.print(T);
-    if (T == 32) { _DROP(); _DUP(); T = counter--; break; } // unrelated 32 - this one's a space char
+    if (vm.T == 32) { _DROP(); _DUP(); vm.T = counter--; break; } // unrelated 32 - this one's a space char
     _DROP();
   }
 }
@@ -275,190 +474,229 @@ void _RBYTE (void) {
 }
 
 void _SWAP (void) {
-  W = memory.data [S];
-  memory.data [S] = T;
-  T = W;
+  vm.W = memory.data [vm.S];
+  memory.data [vm.S] = vm.T;
+  vm.T = vm.W;
 }
 
 void _OVER (void) {
   _DUP ();
-  T = memory.data [S + 1];
+  vm.T = memory.data [vm.S + 1];
 }
 
 void _FETCH (void) {
-  T = memory.data [T];
+  vm.T = MEM_CELL (CELL_OF (vm.T));
+}
+
+// superinstructions - laid down by _COMPILE, never named in the
+// dictionary.  Each does the work of the words in its name.
+
+void _OVEROVER (void) {
+  _OVER ();
+  _OVER ();
+}
+
+void _OVEROVERMINUS (void) {
+  _DUP ();
+  vm.T = memory.data [vm.S + 1] - vm.T;
+}
+
+void _OVEROVERSWAP (void) {
+  _DUP ();
+  _DUP ();
+  vm.T = memory.data [vm.S + 2];
+}
+
+void _OVEROVERSWAPMINUS (void) {
+  _DUP ();
+  vm.T = vm.T - memory.data [vm.S + 1];
+}
+
+void _DUPFETCH (void) {
+  _DUP ();
+  vm.T = MEM_CELL (CELL_OF (vm.T));
+}
+
+void _SWAPDROP (void) {
+  vm.S++;
+}
+
+void _LITPLUS (void) {
+  vm.T += memory.data [vm.I++];
+}
+
+void _LITMINUS (void) {
+  vm.T -= memory.data [vm.I++];
+}
+
+void _LITAND (void) {
+  vm.T &= memory.data [vm.I++];
+}
+
+void _MINUSZEROLESS (void) {
+  vm.W = vm.T;
+  _DROP ();
+  vm.T = ((vm.T - vm.W) < 0) ? -1 : 0;
 }
 
 void _STORE (void) {
-  W = T,
+  vm.W = vm.T,
   _DROP ();
-  memory.data [W] = T;
+  MEM_CELL (CELL_OF (vm.W)) = vm.T;
   _DROP ();
+  NATIVE_STORED (CELL_OF (vm.W));
 }
 
 void _COMMA (void) {
-  memory.data [H++] = T;
+  memory.data [H++] = vm.T;
   _DROP ();
 }
 
 void _MINUS (void) {
-  W = T;
+  vm.W = vm.T;
   _DROP ();
-  T = (T - W);
+  vm.T = (vm.T - vm.W);
 }
 
 void _PLUS (void) {
-  W = T;
+  vm.W = vm.T;
   _DROP ();
-  T = (T + W);
+  vm.T = (vm.T + vm.W);
 }
 
 void _aND (void) {
-  W = T;
+  vm.W = vm.T;
   _DROP ();
-  T = (T & W);
+  vm.T = (vm.T & vm.W);
 }
 
 void _OR (void) {
-  W = T;
+  vm.W = vm.T;
   _DROP ();
-  T = (T | W);
+  vm.T = (vm.T | vm.W);
 }
 
 void _XOR (void) {
-  W = T;
+  vm.W = vm.T;
   _DROP ();
-  T = (T ^ W);
+  vm.T = (vm.T ^ vm.W);
 }
 
 void _INVERT (void) {
-  T = ~T;
+  vm.T = ~vm.T;
 }
 
 void _ABS (void) {
-  T = abs (T);
+  vm.T = abs (vm.T);
 }
 
 void _NEGATE (void) {
-  T = -T;
+  vm.T = -vm.T;
 }
 
 void _TWOSLASH (void) {
-  T = (T >> 1);
+  vm.T = (vm.T >> 1);
 }
 
 void _TWOSTAR (void) {
-  T = (T << 1);
+  vm.T = (vm.T << 1);
 }
 
 void _LIT (void) {
   _DUP (); 
-  T = memory.data [I++];
+  vm.T = memory.data [vm.I++];
 }
 
 void _BRANCH (void) {
-  I = memory.data [I];
+  vm.I = memory.data [vm.I];
 }
 
 void _0BRANCH (void) {
-  if (T == 0) {
-    I = memory.data [I];
+  if (vm.T == 0) {
+    vm.I = memory.data [vm.I];
     _DROP ();
     return;
   }
-  I += 1;
+  vm.I += 1;
   _DROP ();
 }
 
 void _INITR (void) {
-  R = R0;
+  if (task_cur) task_quit ();
+  vm.R = R0;
+  PROF_INITR ();
 }
 
 void _INITS (void) {
-  S = S0;
+  if (task_cur) task_quit ();
+  vm.S = S0;
 }
 
 void _NEST (void) {
-  memory.data [--R] = I;
-  I = (W + 1);
+  memory.data [--vm.R] = vm.I;
+  vm.I = (vm.W + 1);
+  PROF_NEST (vm.W, vm.R);
 }
 
 void _SHOWTIB (void) {
-  W = tib.length ();
-  tib [W - 1] = 0;
-  SERIAL_LOCAL_C.print (tib); // tnr // restored to original
-}
-
-void _set_PKF(void) {
-  PKF = -1;
-}
-void _reset_PKF(void) {
-  PKF = 0;
+  if (tib_in == 0) return; // no token yet - and no tib [-1] to end one
+  vm.W = tib_in;
+  tib [vm.W - 1] = 0;
+  SERIAL_LOCAL_C.print (TOKEN); // tnr // restored to original
+}
+
+// the next token from tib, skipping spaces, and the next line from
+// rx_ring [] when tib runs out.  False when no line has come in yet.
+// True, with the token in tib: it ends with the char before >in
+// (any char up to ' '), as it did in the serial port's stream
+boolean parse_step (void) {
+  for (;;) {
+    while ((tib_in < tib_len) && (tib [tib_in] == ' ')) tib_in++;
+    if (tib_in < tib_len) break;
+    if (!rx_line_ready ()) rx_poll (true);
+    if (!rx_line_ready ()) return false;
+    rx_line ();
+  }
+  tib_tok = tib_in;
+  while (tib [tib_in++] > ' '); // a line ends with one
+  return true;
+}
+
+// the next char of the input, past the token parse left: for cc and
+// s", which read on to a delimiter of their own.  The keyboard's
+// line is all in tib; a file's next token is read in behind the one
+// there.  -1 at the end of the line, or of the file
+int parse_char (void) {
+  if ((tib_in >= tib_len) && !keyboard_not_file && thisFile) {
+    const char *s;
+    int n = lex_next (&s);
+    if (n >= 0) {
+      if (n > LEX_TOKEN_MAX) n = LEX_TOKEN_MAX;
+      memcpy (tib, s, n);
+      tib [n] = ' '; // as _FLPARSE leaves it
+      tib_tok = 0;
+      tib_len = n + 1;
+      tib_in = 0;
+    }
+  }
+  if (tib_in >= tib_len) return -1;
+  return (unsigned char) tib [tib_in++];
 }
 
-int hyster = 0; // no memory
-
-// trim leading spaces
+// the interpreter's: while the line is still to come, the other
+// tasks run
 void _PARSE (void) {
-  char t;
-  tib = "";
-  _reset_PKF(); // haven't peeked yet
-  do {
-    while (!SERIAL_LOCAL_C.available ());
-
-    // ---------------- set the peek flag:
-    t = SERIAL_LOCAL_C.peek (); _set_PKF();
-
-    if (t == ' ') {
-#ifdef DEBUG_PARSE_ECHO
-      SERIAL_LOCAL_C.print ("SPACELY_SPROCKETS"); 
-#endif
-#ifndef DEBUG_PARSE_ECHO
-  #ifdef ECHO_INPUT
-      SERIAL_LOCAL_C.write (t);
-  #endif
-#endif
-      t = SERIAL_LOCAL_C.read ();
-    }
-  } while (t == ' ');
-
-  // ------------------- only a peek gets a write:
-  if (PKF) {
-#ifdef ECHO_INPUT
-    SERIAL_LOCAL_C.write (t);
-#endif
-#ifdef DEBUG_PARSE_ECHO
-    SERIAL_LOCAL_C.print ("TRIPWIRE");
-#endif
+  if (!parse_step ()) {
+    parse_wait ();
+    return;
   }
-  _reset_PKF();
-
-  do {
-    while (!SERIAL_LOCAL_C.available ());
-    t = SERIAL_LOCAL_C.read ();
-    tib = tib + t;
+  io_yield = true;
+}
 
-    if (hyster) {
-      if (!PKF) {
-#ifdef ECHO_INPUT
-        SERIAL_LOCAL_C.write (t);
-#endif
-#ifdef DEBUG_PARSE_ECHO
-        SERIAL_LOCAL_C.print ("RESET");
-#endif
-        _set_PKF();
-      } else {
-#ifdef ECHO_INPUT
-        SERIAL_LOCAL_C.write (t);
-#endif
-#ifdef DEBUG_PARSE_ECHO
-        SERIAL_LOCAL_C.print ("non_RESET");
-#endif
-      }
-    }
-    hyster = -1;
-  } while (t > ' ');
-  hyster = 0; // reset
+// for the words that read a name after them (: forget ..): waits here
+void parse_token (void) {
+  while (!parse_step ());
+  io_yield = true;
 }
 
 // trim leading spaces
@@ -469,307 +707,44 @@ void _PARSE (void) {
 // This Forth does NOT like println() to the file; it wants 'print("foo \r");
 // (08 SEP 2019: that has been corrected - with possible bugs not yet found.
 
-char ti;
-
-void screen_for_comments(void) {
-  if (thisFile.available() > 0) {
-    ti = thisFile.read();
-
-    if (ti == 92) {
-#ifdef DEBUG_COMMENTS_NTWO
-      Serial.println("\r\n GOT YER COMMENT hyah \r\n");
-#endif
-      do {
-
-        if (thisFile.available() > 0) {
-          ti = thisFile.read();
-        }
-
-      } while (ti != 0x0d);
-    }
-
-  }
-}
+// The file is split into tokens by lex_next () in src/lexer.cpp,
+// a sector at a time; each token is copied to tib, alone.
 
 #define FLEN_MAX 1
 void _FLPARSE (void) {
-  char t;
-  tib = "";
+  const char *s;
+  int n = -1;
   keyboard_not_file = false;
-  if (thisFile) {
-    while (thisFile.available() > 1 ) { // FLEN_MAX) {
-
-      do {
-        screen_for_comments(); t = ti;
-        // t = thisFile.read();
-        char peeked_char = t;
-
-
-      do {
-        if (peeked_char == 0x20) {
-            if (thisFile.available() > 0 ) {
-                screen_for_comments(); t = ti;
-                // t = thisFile.read();
-                peeked_char = t; // update
-            }
-        }
-      } while (peeked_char == ' ');
-
-
-
-
-// ###bookmark
-
-
-      do {
-        if (peeked_char == 0x5c) {
-            if (thisFile.available() > 0 ) {
-              screen_for_comments(); t = ti;
-              // t = thisFile.read();
-              peeked_char = t; // update
-            }
-        }
-      } while (peeked_char == 0x5c);
-
-
-
-
-
-
-
-
-
-      do {
-        if (peeked_char == 0x0d) {
-#ifdef DEBUG_FLP_TIB
-            Serial.print(" INTRUSIVE 0x0d SEEN    ");
-#endif
-            if (thisFile.available() > 0 ) {
-              screen_for_comments(); t = ti;
-              // t = thisFile.read();
-              peeked_char = t; // update
-#ifdef DEBUG_FLP_TIB
-              Serial.print(" RESOLVED locally.      ");
-#endif
-            }
-        }
-      } while (peeked_char == 0x0d);
-
-
-
-
-
-
-      do {
-        if (peeked_char == 0x0a) {
-#ifdef DEBUG_FLP_TIB
-            Serial.print(" INTRUSIVE 0x0a SEEN    ");
-#endif
-            if (thisFile.available() > 0 ) {
-              screen_for_comments(); t = ti;
-              // t = thisFile.read();
-              peeked_char = t; // update
-#ifdef DEBUG_FLP_TIB
-              Serial.print(" RESOLVED locally.      ");
-#endif
-            }
-        }
-      } while (peeked_char == 0x0a);
-
-
-
-#ifdef DEBUG_FLP_TIB
-        Serial.print("PEEK: ");
-        Serial.print(peeked_char, HEX);
-        Serial.print("  ");
-#endif
-        // delay(300); // LONG DELAY can be here for debug 09 SEP tnr
-        // }
-        if ((peeked_char != '\r') && (peeked_char != '\n'))
-        tib = peeked_char;
-        if (t == ' ') {
-          tib = ""; // unpeek tib
-          screen_for_comments(); t = ti;
-          // t = thisFile.read();
-        }
-      } while (t == ' ');
-
-
-      do {
-        screen_for_comments(); t = ti;
-        // t = thisFile.read();
-
-
-        if (tib[0] == '\r') {
-            tib = "";
-#ifdef DEBUG_FLP_TIB
-            Serial.println("ALERT tib was '\'r");
-#endif
-        }
-
-
-        if (tib[0] == '\n') tib = "";
-
-
-#ifdef DEBUG_FLP_TIB
-        if (t == 0x0d) Serial.println("\r\n    0x0d  SEEN");
-        if (t == 0x0a) Serial.println("\r\n    0x0a  SEEN");
-#endif
-
-
-
-
-        if ((t == '\r') || (t == '\n') ) {
-#ifdef DEBUG_FLP_TIB
-            Serial.println("\r\n\r\n     ATTENTION: EOL stuff here.\r\n");
-#endif
-        }
-
-// ###bookmark
-        if ((t != '\r') && (t != '\n') )
-          tib = tib + t;
-
-#ifdef DEBUG_FLP_TIB
-      Serial.print(" t was > ' ' ");
-#endif
-
-      } while (t > ' ');
-
-#ifdef DEBUG_FLP_TIB
-      Serial.print(" okay so tib is now: "); Serial.print(tib);
-      Serial.print("   tib.length is: "); Serial.println((tib.length () -1));
-      if (tib[(tib.length () - 1)] == ' ') Serial.println("HEY HEY HEY HEY HEY HEY HEY HEY");
-#endif
-
-//    if (tib[(tib.length () - 1)] != ' ') Serial.println("OUCH OUCH OUCH OUCH OUCH OUCH\r\n\r\nOUCH OUCH OUCH OUCH");
-
-
-/* kludge */
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-      if (tib[(tib.length () - 1)] != ' ') {
-          tib = tib + ' ';
-#ifdef DEBUG_FLP_TIB
-          Serial.print("  kfc "); // nonsense tag
-#endif
-      }
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-/* kludge */
-
-
-      if (
-          (tib.length () == 1) &&
-          (tib[0] == ';')
-      ) {
-#ifdef DEBUG_FLP_TIB
-          Serial.println("\r\n  TIB has the semicolon \r\n");
-
-          Serial.println("");
-          Serial.print("TIB: ");
-          if (tib.length() > 0) { Serial.print(tib[0], HEX); Serial.print(' '); }
-          if (tib.length() > 1) { Serial.print(tib[1], HEX); Serial.print(' '); }
-          if (tib.length() > 2) { Serial.print(tib[2], HEX); Serial.print(' '); }
-          if (tib.length() > 3) { Serial.print(tib[3], HEX); Serial.print(' '); }
-          if (tib.length() > 4) { Serial.print(tib[4], HEX); Serial.print(' '); }
-          Serial.println("");
-#endif
-          tib = tib + ' ';
-
-#ifdef DEBUG_FLP_TIB_SEMICOLON
-          Serial.print(" REVISED: so tib is now: "); Serial.print(tib);
-          Serial.print("   REVISED: tib.length is: "); Serial.println((tib.length () -1));
-
-
-          Serial.println("");
-          Serial.print("REV_TIB: ");
-          if (tib.length() > 0) { Serial.print(tib[0], HEX); Serial.print(' '); }
-          if (tib.length() > 1) { Serial.print(tib[1], HEX); Serial.print(' '); }
-          if (tib.length() > 2) { Serial.print(tib[2], HEX); Serial.print(' '); }
-          if (tib.length() > 3) { Serial.print(tib[3], HEX); Serial.print(' '); }
-          if (tib.length() > 4) { Serial.print(tib[4], HEX); Serial.print(' '); }
-          Serial.println("");
-#endif
-
-      }
-/*
-      if (
-          (tib.length () == 0) &&
-          (tib == ';')
-      ) Serial.println("\r\n  TIB has the semicolon \r\n");
-*/
-
-/*
-      if (thisFile.available() < 3) {
-        do {
-          t = thisFile.read();
-        } while (t < '!'); // strip off 0x20 0x0d 0x0a chars
-      }
-*/
-#ifdef DEBUG_FLP_TIB
-      Serial.print("available: "); Serial.println( thisFile.available());
-      Serial.print(" t = "); Serial.print(t, HEX); Serial.print(' ');
-#endif
-
-      // forth/ascii_xfer_a001.txt
-
-      if (thisFile.available() < 2) {
-        // SERIAL_LOCAL_C.println("SAFETY NET");
-        if (thisFile.available() < 1) { // RECENT: 2
-          keyboard_not_file = true;
-          thisFile.close();
-          SERIAL_LOCAL_C.print("\r");
-          SERIAL_LOCAL_C.print(FILE_NAME);
-          SERIAL_LOCAL_C.println(" was closed - Cortex-Forth.ino LINE 617 - route A");
-        }
-        if (thisFile.available() == 1) {
-          screen_for_comments(); t = ti;
-          // t = thisFile.read();
-          if (thisFile.available() == 0) {
-            thisFile.close();
-            SERIAL_LOCAL_C.print("\r");
-            SERIAL_LOCAL_C.print(FILE_NAME);
-            SERIAL_LOCAL_C.println(" was closed - Cortex-Forth.ino LINE 625 - route B");
-          }
-        }
-      }
-      // SERIAL_LOCAL_C.println("TRAP");
-#ifdef DEBUG_FLP_TIB
-      Serial.println("RETURN seen");
-#endif
-      return; /* return for each parsed word, with occasional Ok happening related to that return, but not every single time: */
+  if (thisFile) n = lex_next (&s);
+  if (n < 0) {
+    if (thisFile) {
+      thisFile.close();
+      lex_reset();
+      if (!state) seg_save (base); // src/image.cpp
+      SERIAL_LOCAL_C.print("\r");
+      SERIAL_LOCAL_C.print(FILE_NAME);
+      SERIAL_LOCAL_C.println(" was closed - Cortex-Forth.ino _FLPARSE");
     }
-    SERIAL_LOCAL_C.println(" alt TRAP LINE 502");
-    while(-1);
-    delay(1400);
-    delay(1400);
-    delay(1400);
-    delay(1400);
-    delay(1400);
-    delay(1400);
-    delay(1400);
-    delay(1400);
-    delay(1400);
-  } // if thisfile
-  else {
-    // SERIAL_LOCAL_C.println(" alt TRAP LINE 506");
     keyboard_not_file = true;
-    I = 90; // I = 90 points to 'parse' - top of original quit loop
-
-    // shows just one time during system init:
-    // Serial.println("\r\nDEBUG 08 SEP: LINE 511 seen.\r\n");
+    vm.I = K_quit_loop; // points to 'parse' - top of original quit loop
+    return;
   }
+  if (n > LEX_TOKEN_MAX) n = LEX_TOKEN_MAX;
+  memcpy (tib, s, n);
+  tib [n] = ' '; // the char that ended it, as _PARSE leaves it
+  tib_tok = 0;
+  tib_len = tib_in = (n + 1);
 }
 
 void _SFPARSE (void) { // safe parse
-  char t;
-  tib = "";
+  tib_tok = tib_len = tib_in = 0;
   keyboard_not_file = false;
 
 /*
 
 assume: this never did get used.  Age it.  It'll break something sooner or later, if it was really needed.
 
+  char t;
   if (thisFile) {
     while (thisFile.available() > FLEN_MAX) {
       do {
@@ -802,7 +777,7 @@ assume: this never did get used.  Age it.  It'll break something sooner or later
   else {
     // SERIAL_LOCAL_C.println(" alt TRAP LINE 339");
     keyboard_not_file = true;
-    I = 90; // I = 90 points to 'parse' - top of original quit loop
+    I = K_quit_loop; // points to 'parse' - top of original quit loop
   }
 
 
@@ -813,107 +788,283 @@ assume: this never did get used.  Age it.  It'll break something sooner or later
 
 
 
-void _WORD (void) {
-  char t;
-  _DUP (); // what are we dup'ing here
-  T = (tib.length () - 1);
-  W = T;
-  t = tib [0];
+/*  names
+
+  A header's name cell holds the length of the name (low 7 bits),
+  the IMMED flag, and a 24 bit hash of the whole name above them.
+  _FIND compares name cells, and looks at the letters only when
+  two of them agree.
+
+  The letters of a word made by _HEAD are packed 4 to a cell, first
+  letter lowest, in the cells just below its name cell.  The kernel
+  words keep theirs in flash: each WORD line of kernel.h puts its
+  string in kernel_names [].
+*/
+
+#define NAME_MAX 127     // longest name - the length has 7 bits
+
+struct kernel_name {
+  int a;          // header
+  const char *s;  // name, in flash
+};
 
-  // looks like tib needs the follow-on character here
+extern const struct kernel_name kernel_names []; // made from kernel.h, above setup ()
+extern const int kernel_named;
 
-  T |= (t << 8);
-  if (W > 1) {
-    t = tib [1];
-    T |= (t << 16);
+int name_key (const char *s, int len) { // NAME_KEY (vm.h), for a name typed in
+  if (len > NAME_MAX) len = NAME_MAX;
+  return name_fold (name_fnv (s, len, 2166136261u), len);
+}
+
+const char *kernel_name (int a) { // 0 if a is not a kernel header
+  int lo = 0, hi = kernel_named - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (kernel_names [mid].a == a) return kernel_names [mid].s;
+    if (kernel_names [mid].a < a) lo = mid + 1;
+    else hi = mid - 1;
   }
-  if (W > 2) {
-    t = tib [2];
-    T |= (t << 24);
+  return 0;
+}
+
+int name_cells (int a) { // cells of letters below the header at a
+  if (kernel_name (a)) return 0;
+  return ((memory.data [a] & 0x7f) + 3) / 4;
+}
+
+// copy the name of the header at a into buf, NAME_MAX + 1 chars
+int name_copy (int a, char *buf) {
+  int len = memory.data [a] & 0x7f;
+  const char *k = kernel_name (a);
+  int base = a - ((len + 3) / 4);
+  for (int i = 0; i < len; i++) {
+    buf [i] = k ? k [i] : ((memory.data [base + (i / 4)] >> (8 * (i % 4))) & 0xff);
   }
-  // SERIAL_LOCAL_C.print(" ~k~ ");
-  // SERIAL_LOCAL_C.println(" --- _WORD  exits --- ");
+  buf [len] = 0;
+  return len;
+}
+
+// the header of the word with code field cfa, or 0: it has none
+int cfa_header (int cfa) {
+  for (int h = D; h; h = memory.data [h + 1]) {
+    if ((h + 2) == cfa) return h;
+  }
+  return 0;
+}
+
+// the header of the word that cell a is in: the last made below it
+int header_below (int a) {
+  for (int h = D; h; h = memory.data [h + 1]) {
+    if (h < a) return h;
+  }
+  return 0;
+}
+
+// the name of the word with code field cfa, or [cfa]; returns
+// the chars printed
+int dot_cfa (int cfa) {
+  char name [NAME_MAX + 1];
+  int h = cfa_header (cfa);
+  if (h) {
+    name_copy (h, name);
+    return SERIAL_LOCAL_C.print (name);
+  }
+  return SERIAL_LOCAL_C.write ('[') + SERIAL_LOCAL_C.print (cfa) + SERIAL_LOCAL_C.write (']');
+}
+
+// v, in decimal, right aligned in width
+void dot_right (long v, int width) {
+  int digits = (v < 0) ? 2 : 1;
+  for (long x = (v < 0) ? -v : v; x >= 10; x /= 10) digits++;
+  for (; digits < width; digits++) SERIAL_LOCAL_C.write (' ');
+  SERIAL_LOCAL_C.print (v);
+}
+
+// does the header at a have the name s, len long?  Its name cell
+// has been checked already.
+boolean name_is (int a, const char *s, int len) {
+  const char *k = kernel_name (a);
+  if (k) return strncmp (k, s, len) == 0;
+  int base = a - ((len + 3) / 4);
+  for (int i = 0; i < len; i++) {
+    if (((memory.data [base + (i / 4)] >> (8 * (i % 4))) & 0xff) != (unsigned char) s [i]) return false;
+  }
+  return true;
+}
+
+// lay down the letters of the token in tib, below the header to come
+void name_comma (void) {
+  int len = TOKEN_LEN;
+  if (len > NAME_MAX) len = NAME_MAX;
+  for (int i = 0; i < len; i += 4) {
+    unsigned int c = 0;
+    for (int j = 0; (j < 4) && ((i + j) < len); j++) {
+      c |= ((unsigned int) (unsigned char) TOKEN [i + j]) << (8 * j);
+    }
+    memory.data [H++] = (int) c;
+  }
+}
+
+void _WORD (void) { // name cell of the token in tib
+  _DUP ();
+  vm.W = TOKEN_LEN;
+  vm.T = name_key (TOKEN, vm.W);
 }
 
 void _NUMBER (void) {
   char t;
   _DUP ();
-  T = 0;
-  for (int i = 0; i < (tib.length () - 1); i++) {
+  vm.T = 0;
+  for (int i = 0; i < TOKEN_LEN; i++) {
     if (i == 0) {
-      if (tib [i] == '-') continue;
+      if (TOKEN [i] == '-') continue;
     }
-    t = tib [i];
+    t = TOKEN [i];
     if (!isDigit (t)) {
-    if (tib [0] == '-') T = -T;
+    if (TOKEN [0] == '-') vm.T = -vm.T;
       _DUP ();
-      T = -1;
+      vm.T = -1;
       return;
     }
-    T *= base;
+    vm.T *= base;
     t -= '0';
     if (t > 9) t -= 37;
-    T += t;
+    vm.T += t;
   }
-  if (tib [0] == '-') T = -T;
+  if (TOKEN [0] == '-') vm.T = -vm.T;
       if (state == true) {
         _DUP ();
-        T = 1; // forward reference to lit
-        _COMMA (); // lit
+        vm.T = K_lit;
+        _COMPILE (); // lit
         _COMMA (); // the number
       }
   _DUP ();
-  T = 0;
+  vm.T = 0;
 }
 
 void _EXECUTE (void) {
   if (state == true) {
-    if (((memory.data [T]) & 0x80) == 0) {
-      T += 2;
-      _COMMA ();
+    if (((memory.data [vm.T]) & 0x80) == 0) {
+      vm.T += 2;
+      _COMPILE ();
       return;
     }
+    fuse_h = -1; // an immediate word may leave a branch target at H
   }
-  W = (T + 2);
+  vm.W = (vm.T + 2);
   _DROP ();
-  memory.program [W] ();
+  PROF_COUNT (vm.W);
+  PROGRAM (vm.W) ();
+}
+
+/*  dictionary index
+
+  dict_slot [] is an open addressed hash table of the headers
+  reachable from D, keyed by the name cell (immediate bit masked
+  off), each name once: the latest word of that name, as a walk
+  down the links from D would find it.  _HEAD adds each new word;
+  anything that moves D back (forget) calls dict_rehash ().
+
+  At 3/4 load a new name is not added: it is counted in dict_spilled,
+  and _FIND, when the index misses, walks the links for it.  Names in
+  the index are still found in it.  A word redefining an indexed name
+  takes its slot, so a hit is always the latest of that name.
+*/
+
+// the slot holding the name s, len long, with name cell X - or
+// the empty slot for it
+int dict_probe (int X, const char *s, int len) {
+  unsigned int i = (((unsigned int) X * 2654435761u) >> 16) & (DICT_SLOTS - 1);
+  while (dict_slot [i]) {
+    int a = dict_slot [i];
+    if ((NAME_CELL (memory.data [a]) == X) && name_is (a, s, len)) break;
+    i = (i + 1) & (DICT_SLOTS - 1);
+  }
+  return i;
+}
+
+int dict_probe_header (int a) {
+  char name [NAME_MAX + 1];
+  int len = name_copy (a, name);
+  return dict_probe (NAME_CELL (memory.data [a]), name, len);
+}
+
+void dict_add (int a) { // index the header at a, replacing an older one
+  int i = dict_probe_header (a);
+  if (dict_slot [i] == 0) {
+    if (dict_used >= ((DICT_SLOTS * 3) / 4)) { // keep probes short
+      dict_spilled++;
+      return;
+    }
+    dict_used++;
+  }
+  dict_slot [i] = a;
+}
+
+void dict_rehash (void) { // index the words reachable from D, afresh
+#ifdef HOST_NATIVE
+  native_forget (H);
+#endif // #ifdef HOST_NATIVE
+  memset (dict_slot, 0, sizeof (dict_slot));
+  dict_used = 0;
+  dict_spilled = 0;
+  for (int a = D; a != 0; a = memory.data [a + 1]) {
+    int i = dict_probe_header (a);
+    if (dict_slot [i]) continue; // a later word has the name
+    if (dict_used >= ((DICT_SLOTS * 3) / 4)) {
+      dict_spilled++; // older than all in the index, and not shadowed
+      continue;
+    }
+    dict_used++;
+    dict_slot [i] = a;
+  }
 }
 
-void _FIND (void) {
-  int X = T;
-  T = D;
-  while (T != 0) {
-    W = (memory.data [T]);
-    if ((W & 0xffffff7f) == X) {
+void _FIND (void) { // ( n - a) n from _WORD, with the token still in tib
+  int X = vm.T;
+  const char *s = TOKEN;
+  int len = (X & 0x7f);
+  if (dict_indexed) {
+    vm.T = dict_slot [dict_probe (X, s, len)];
+    if (vm.T) {
+      vm.W = memory.data [vm.T];
+      return;
+    }
+    if (dict_spilled == 0) return;
+  }
+  vm.T = D;
+  while (vm.T != 0) {
+    vm.W = (memory.data [vm.T]);
+    if ((NAME_CELL (vm.W) == X) && name_is (vm.T, s, len)) {
       // SERIAL_LOCAL_C.println("FIND exits - and its a word.");
       return;
     }
-    T = memory.data [T + 1];
+    vm.T = memory.data [vm.T + 1];
   }
   // SERIAL_LOCAL_C.println("FIND exits.");
 }
 
 void _DOT (void) {
-  SERIAL_LOCAL_C.print (T);
+  SERIAL_LOCAL_C.print (vm.T);
   SERIAL_LOCAL_C.write (' ');
   _DROP ();
 }
 
 void _HDOT (void) {
-  SERIAL_LOCAL_C.print (T, HEX);
+  SERIAL_LOCAL_C.print (vm.T, HEX);
   SERIAL_LOCAL_C.write (' ');
   _DROP ();
 }
 
 void _DDOTS (void) {
-  if (S == S0) {
+  if (vm.S == task_s0) {
     SERIAL_LOCAL_C.print ("empty ");
     return;
   }
   _DUP ();
-  W = (S0 - 1);
-  while (W > (S)) {
-    SERIAL_LOCAL_C.print (memory.data [--W]);
+  vm.W = (task_s0 - 1);
+  while (vm.W > (vm.S)) {
+    SERIAL_LOCAL_C.print (memory.data [--vm.W]);
     SERIAL_LOCAL_C.write (' ');
   }
   _DROP ();
@@ -924,59 +1075,57 @@ void _SPACE () {
 }
 
 void _ZEROEQUAL () {
-  if (T == 0) {
-    T = -1;
+  if (vm.T == 0) {
+    vm.T = -1;
     return;
   }
-  T = 0;
+  vm.T = 0;
 }
 
 void _ZEROLESS () {
-  if (T < 0) {
-    T = -1;
+  if (vm.T < 0) {
+    vm.T = -1;
     return;
   }
-  T = 0;
+  vm.T = 0;
 }
 
 void _DOTWORD () {
-  int Y = memory.data [W];
-  int X = (Y & 0xff);
+  char name [NAME_MAX + 1];
+  int X = (memory.data [vm.W] & 0xff);
   SERIAL_LOCAL_C.write ('[');
   SERIAL_LOCAL_C.print (X);
   SERIAL_LOCAL_C.write (' ');
-  X = ((Y >> 8) & 0xff);
-  _DUP (); T = X; _EMIT ();
-  X = ((Y >> 16) & 0xff);
-  if (X != 0) { _DUP (); T = X; _EMIT (); }
-  X = ((Y >> 24) & 0xff);
-  if (X != 0) { _DUP (); T = X; _EMIT (); }
+  name_copy (vm.W, name);
+  SERIAL_LOCAL_C.print (name);
   SERIAL_LOCAL_C.print ("] "); 
 }
 
 void _WORDS (void) {
   int i = 0;
-  W = D;
+  vm.W = D;
   do {
     _DOTWORD ();
-    W = memory.data [++W];
+    vm.W++;
+    vm.W = memory.data [vm.W];
     i += 1;
     if ((i % 8) == 0) _CR ();
-  } while (memory.data [W + 1]);
+  } while (memory.data [vm.W + 1]);
 }
 
 void _DEPTH (void) {
-  W = S0 - S;
+  vm.W = task_s0 - vm.S;
   _DUP ();
-  T = W;
+  vm.T = vm.W;
 }
 
 void _DUMP (void) {
-  int a = T;
+  int a = vm.T;
   _DROP ();
   for (int i = 0; i < a; i++) {
-    W = T;
-    SERIAL_LOCAL_C.print (memory.data [T++], HEX);
+    vm.W = CELL_OF (vm.T);
+    vm.T += 4;
+    SERIAL_LOCAL_C.print (MEM_CELL (vm.W), HEX);
     // SERIAL_LOCAL_C.write (' ');
     SERIAL_LOCAL_C.write (" ~dump_delimiter~ ");
     _DOTWORD ();
@@ -985,48 +1134,69 @@ void _DUMP (void) {
 
 void _HERE (void) {
   _DUP ();
-  T = H;
+  vm.T = H * 4;
+}
+
+void _UNUSED (void) { // ( - u) bytes left in the dictionary
+  _DUP ();
+  vm.T = (DICT_CELLS - H) * 4;
+}
+
+void _STACKROOM (void) { // ( - s r) cells left on the running task's stacks
+  int s = vm.S - S_FLOOR - 1, r = vm.R - R_FLOOR - 1;
+  _DUP ();
+  vm.T = s;
+  _DUP ();
+  vm.T = r;
+}
+
+void _PAD (void) { // ( - b) the scratch region (vm.h)
+  _DUP ();
+  vm.T = PAD * 4;
 }
 
-void _ALLOT (void) {
-  H += T;
+void _ALLOT (void) { // bytes, rounded up to a cell
+  H += (vm.T + 3) >> 2;
   _DROP ();
 }
 
 void _HEAD (void) {
   if ( keyboard_not_file ) {
-    _PARSE ();
+    parse_token ();
   } else {
     _FLPARSE ();
   }
 //  _PARSE ();
+  name_comma ();
   _WORD ();
   _COMMA ();
   _DUP ();
-  T = D;
+  vm.T = D;
   _COMMA ();
   D = H - 2;
+  dict_add (D);
 }
 
 void _DOVAR (void) {
   _DUP ();
-  T = (W + 1);
+  vm.T = (vm.W + 1) * 4;
 }
 
 void _CREATE (void) {
   _HEAD ();
   _DUP ();
   _DUP ();
-  memory.program [S] = _DOVAR;
+  memory.data [vm.S] = FN_CELL (_DOVAR);
   _DROP ();
   _COMMA ();
 }
 
 void _COLON (void) {
+  leave_list = 0;
   _HEAD ();
   _DUP ();
   _DUP ();
-  memory.program [S] = _NEST;
+  memory.data [vm.S] = FN_CELL (_NEST);
   _DROP ();
   _COMMA ();
   _RBRAC ();
@@ -1034,21 +1204,25 @@ void _COLON (void) {
 
 void _SEMI (void) {
   _DUP ();
-  T = 25; // forward reference to exit 
+  vm.T = K_exit;
   _COMMA (); // compile exit
   _LBRAC (); // stop compiling
+  seg_semi (D + 2);
+#ifdef HOST_NATIVE
+  native_compile (D + 2);
+#endif // #ifdef HOST_NATIVE
 }
 
 void _DOCONST (void) {
   _DUP ();
-  T = memory.data [W + 1];
+  vm.T = memory.data [vm.W + 1];
 }
 
 void _CONSTANT (void) {
   _HEAD ();
   _DUP ();
   _DUP ();
-  memory.program [S] = _DOCONST;
+  memory.data [vm.S] = FN_CELL (_DOCONST);
   _DROP ();
   _COMMA ();
   _COMMA ();
@@ -1066,75 +1240,137 @@ void _QUESTION (void) {
 
 void _R (void) {
   _DUP ();
-  T = R;
+  vm.T = vm.R * 4;
 }
 
+/*  do loops
+
+  do puts two cells on the return stack: the limit, on top, and
+  under it the index less the limit.  That offset runs up to 0,
+  so loop changes one cell and tests it for 0; i adds the limit
+  back.  +loop ends the loop when the offset crosses from -1 to 0,
+  either way, as the standard has it.
+*/
+
 void _DO (void) {
-  memory.data [--R] = T;
+  memory.data [--vm.R] = (vm.T - memory.data [vm.S]); // index - limit
   _DROP ();
-  memory.data [--R] = T;
+  memory.data [--vm.R] = vm.T;
   _DROP ();
 }
 
 void _LOOP (void) {
-  int X = memory.data [R++];
-  W = (memory.data [R++] + 1);
-  if (W == X) {
-    I += 1;
+  if (++memory.data [vm.R + 1]) {
+    vm.I = memory.data [vm.I];
     return;
   }
-  memory.data [--R] = (W);
-  memory.data [--R] = X;
-  I = memory.data [I];
+  vm.R += 2;
+  vm.I += 1;
+}
+
+void _PLOOP (void) { // +loop ( n - )
+  int X = memory.data [vm.R + 1];
+  vm.W = vm.T;
+  _DROP ();
+  int Y = (int) ((unsigned int) X + vm.W); // wraps, as on the Cortex-M
+  memory.data [vm.R + 1] = Y;
+  if (((X ^ Y) >= 0) || ((X ^ vm.W) >= 0)) {
+    vm.I = memory.data [vm.I];
+    return;
+  }
+  vm.R += 2;
+  vm.I += 1;
+}
+
+void _LEAVE (void) {
+  vm.R += 2;
+  vm.I = memory.data [vm.I];
+}
+
+void _UNLOOP (void) {
+  vm.R += 2;
 }
 
 void _I (void) {
   _DUP ();
-  T = memory.data [R + 1];
+  vm.T = memory.data [vm.R + 1] + memory.data [vm.R];
+}
+
+void _J (void) {
+  _DUP ();
+  vm.T = memory.data [vm.R + 3] + memory.data [vm.R + 2];
 }
 
-void _CDO (void) {
+void _CDO (void) { // (  - list a) the enclosing loop's leaves, and the top
   _DUP ();
-  T = 4; // forward reference to ddo
+  vm.T = K_ddo;
   _COMMA ();
   _DUP ();
-  T = H;
+  vm.T = leave_list;
+  leave_list = 0;
+  _DUP ();
+  vm.T = H;
 }
 
-void _CLOOP (void) {
+void loop_end (int op) { // ( list a - ) lay down loop or +loop, send the leaves past it
   _DUP ();
-  T = 5; // forward reference to lloop
+  vm.T = op;
   _COMMA ();
   _COMMA (); // address left on stack by do
+  while (leave_list) {
+    int next = memory.data [leave_list];
+    memory.data [leave_list] = H;
+    leave_list = next;
+  }
+  leave_list = vm.T;
+  _DROP ();
+}
+
+void _CLOOP (void) {
+  loop_end (K_lloop);
+}
+
+void _CPLOOP (void) {
+  loop_end (K_plloop);
+}
+
+void _CLEAVE (void) {
+  _DUP ();
+  vm.T = K_lleave;
+  _COMMA ();
+  _DUP ();
+  vm.T = leave_list;
+  leave_list = H;
+  _COMMA (); // patched by loop
 }
 
 void _CBEGIN (void) {
   _DUP ();
-  T = H;
+  vm.T = H;
 }
 
 void _CUNTIL (void) {
   _DUP ();
-  T = 3; // forward reference to Obranch
+  vm.T = K_zbranch;
   _COMMA ();
   _COMMA (); // address left on stack by begin
 }
 
 void _CAGAIN (void) {
   _DUP ();
-  T = 2; // forward reference to branch
+  vm.T = K_branch;
   _COMMA ();
   _COMMA (); // address left on stack by begin
 }
 
 void _CIF (void) {
   _DUP ();
-  T = 3; // forward reference to 0branch
+  vm.T = K_zbranch;
   _COMMA ();
   _DUP ();
-  T = H; // address that needs patching later
+  vm.T = H; // address that needs patching later
   _DUP ();
-  T = 0;
+  vm.T = 0;
   _COMMA (); // dummy in address field
 }
 
@@ -1144,10 +1380,8 @@ void _CWHILE (void) {
 }
 
 void _CTHEN (void) {
-  _DUP ();
-  T = H;
-  _SWAP ();
-  _STORE ();
+  memory.data [vm.T] = H; // a cell number, from if
+  _DROP ();
 }
 
 void _CREPEAT (void) {
@@ -1157,58 +1391,395 @@ void _CREPEAT (void) {
 
 void _CELSE (void) {
   _DUP ();
-  T = 2; // forward reference to branch
+  vm.T = K_branch;
   _COMMA ();
   _DUP ();
-  T = H; // address that needs patching later
+  vm.T = H; // address that needs patching later
   _DUP ();
-  T = 0;
+  vm.T = 0;
   _COMMA (); // dummy in address field
   _SWAP ();
   _CTHEN ();
 }
 
 void _FORGET (void) {
-  _PARSE ();
+  parse_token ();
   _WORD ();
   _FIND ();
-  D = memory.data [T + 1];
-  H = T;
+  D = memory.data [vm.T + 1];
+  H = vm.T - name_cells (vm.T);
   _DROP ();
+  dict_rehash ();
+  task_forget (H);
 }
 
 void _TICK (void) {
   SERIAL_LOCAL_C.println("WHOOPS - _TICK encountered! ");
-  _PARSE ();
+  parse_token ();
   _WORD ();
   _FIND ();
 }
 
 void _CLITERAL (void) {
   _DUP ();
-  T = 1; // forward reference to lit
-  _COMMA ();
+  vm.T = K_lit;
+  _COMPILE ();
   _COMMA (); // the number that was already on the stack
 }
 
 void _CFETCH (void) {
-  W = (T % 4);
-  T = memory.data [T / 4];
-  T = (T >> (W * 8) & 0xff);
-} 
+  vm.T = MEM_BYTE (vm.T);
+}
 
 void _CSTORE (void) {
-  int X = (T / 4);
-  W = (T % 4);
+  vm.W = vm.T;
   _DROP ();
-  T = (T << (W * 8));
-  T = (T | (memory.data [X] & ~(0xff << (W * 8))));
-  memory.data [X] = T;
+  MEM_BYTE (vm.W) = vm.T;
   _DROP ();
-} 
+  NATIVE_STORED (CELL_OF (vm.W));
+}
+
+/*  bulk memory
+
+  Byte addresses and counts (see vm.h).  move is a memmove, right
+  whichever way the two overlap.  cmove copies low byte first and
+  cmove> high byte first, so an overlap runs the way the standard
+  says; where it cannot make a difference, both are a memmove.
+  A range that runs outside
+  memory.data is left alone, and the arguments dropped.
+*/
+
+boolean in_ram (int a, int n, int size) {
+  if ((a >= 0) && (n >= 0) && (n <= (size - a))) return true;
+#ifdef MEM_CHECKED
+  mem_trap ("range from", a);
+#endif
+  return false;
+}
+
+void _CMOVE (void) { // ( b1 b2 u - )
+  int u = vm_pop (&vm), dst = vm_pop (&vm), src = vm_pop (&vm);
+  unsigned char *m = MEM_BYTES;
+  if (!in_ram (src, u, sizeof (memory.data)) || !in_ram (dst, u, sizeof (memory.data))) return;
+  if ((dst <= src) || (dst >= (src + u))) memmove (m + dst, m + src, u);
+  else for (int i = 0; i < u; i++) m [dst + i] = m [src + i];
+  NATIVE_STORED_CELLS (CELL_OF (dst), CELL_OF (dst + u + 3));
+}
+
+void _TYPE (void) { // ( b u - ) one write, to the console
+  int u = vm_pop (&vm), a = vm_pop (&vm);
+  if ((u <= 0) || !in_ram (a, u, sizeof (memory.data))) return;
+  SERIAL_LOCAL_C.write (MEM_BYTES + a, u);
+}
+
+void _CMOVEUP (void) { // ( b1 b2 u - ) cmove>
+  int u = vm_pop (&vm), dst = vm_pop (&vm), src = vm_pop (&vm);
+  unsigned char *m = MEM_BYTES;
+  if (!in_ram (src, u, sizeof (memory.data)) || !in_ram (dst, u, sizeof (memory.data))) return;
+  if ((dst >= src) || ((dst + u) <= src)) memmove (m + dst, m + src, u);
+  else for (int i = u - 1; i >= 0; i--) m [dst + i] = m [src + i];
+  NATIVE_STORED_CELLS (CELL_OF (dst), CELL_OF (dst + u + 3));
+}
+
+void _MOVE (void) { // ( a1 a2 u - )
+  int u = vm_pop (&vm), dst = vm_pop (&vm), src = vm_pop (&vm);
+  if (!in_ram (src, u, sizeof (memory.data)) || !in_ram (dst, u, sizeof (memory.data))) return;
+  memmove (MEM_BYTES + dst, MEM_BYTES + src, u);
+  NATIVE_STORED_CELLS (CELL_OF (dst), CELL_OF (dst + u + 3));
+}
+
+void _FILL (void) { // ( b u c - )
+  int c = vm_pop (&vm), u = vm_pop (&vm), b = vm_pop (&vm);
+  if (!in_ram (b, u, sizeof (memory.data))) return;
+  memset (MEM_BYTES + b, c, u);
+  NATIVE_STORED_CELLS (CELL_OF (b), CELL_OF (b + u + 3));
+}
+
+void _ERASE (void) { // ( b u - )
+  _DUP ();
+  vm.T = 0;
+  _FILL ();
+}
+
+void _MICROS (void) {
+  _DUP ();
+  vm.T = (int) micros ();
+}
+
+void _DOTNAME (void) { // ( a - )
+  char name [NAME_MAX + 1];
+  name_copy (vm.T, name);
+  _DROP ();
+  SERIAL_LOCAL_C.print (name);
+  SERIAL_LOCAL_C.write (' ');
+}
+
+/*  trace - see vm.h
+
+  .trace  the instructions in the ring, oldest first: where each
+          was (and in what word), the word it ran, and T and the
+          depth of each stack as it started.  The copy kept at a ~,
+          if there is one, instead
+*/
+
+#ifdef TRACE
+struct trace_entry trace_ring [TRACE_SLOTS];
+unsigned int trace_n = 0;
+struct trace_entry trace_kept [TRACE_SLOTS]; // the ring, at a ~
+unsigned int trace_kept_n = 0;               // its trace_n then, 0: none kept
+
+void trace_list (struct trace_entry *ring, unsigned int count) {
+  unsigned int n = (count < TRACE_SLOTS) ? count : TRACE_SLOTS;
+  SERIAL_LOCAL_C.println ("\r\n     I  word                T   S   R");
+  for (unsigned int k = count - n; k != count; k++) {
+    struct trace_entry *e = &ring [k & (TRACE_SLOTS - 1)];
+    dot_right (e->I, 6);
+    SERIAL_LOCAL_C.write (' ');
+    for (int w = dot_cfa (e->W); w < 10; w++) SERIAL_LOCAL_C.write (' ');
+    dot_right (e->T, 12);
+    dot_right (S0 - e->S, 4);
+    dot_right (R0 - e->R, 4);
+    int h = header_below (e->I);
+    if (h) {
+      SERIAL_LOCAL_C.print ("  in ");
+      dot_cfa (h + 2);
+    }
+    SERIAL_LOCAL_C.println ();
+  }
+}
+
+void trace_dump (void) { // the ring as it is
+  trace_list (trace_ring, trace_n);
+}
+#endif // #ifdef TRACE
+
+// the file interpreter met a word it does not know: keep the ring
+// as it led up to that, for .trace - the first ~ since the last
+void _TRACEHOLD (void) {
+#ifdef TRACE
+  if (trace_kept_n) return;
+  memcpy (trace_kept, trace_ring, sizeof (trace_kept));
+  trace_kept_n = trace_n;
+#endif
+}
+
+void _DOTTRACE (void) {
+#ifdef TRACE
+  if (trace_kept_n) {
+    SERIAL_LOCAL_C.print ("\r\nas at the ~ of the file interpreter");
+    trace_list (trace_kept, trace_kept_n);
+    trace_kept_n = 0;
+    return;
+  }
+  trace_dump ();
+#else
+  SERIAL_LOCAL_C.print (" not built with TRACE ");
+#endif
+}
+
+/*  profiler - src/profile.cpp, in a PROFILE build (vm.h)
+
+  profile-on     count and time words from here
+  profile-off    stop; what was counted stays
+  profile-reset  forget what was counted
+  .profile       ( n - ) the n words with the most time in their
+                 own instructions, with how often each was executed
+*/
+
+void _PROFON (void) {
+#ifdef PROFILE
+  prof_on ();
+#else
+  SERIAL_LOCAL_C.print (" not built with PROFILE ");
+#endif
+}
+
+void _PROFOFF (void) {
+#ifdef PROFILE
+  profiling = 0;
+#endif
+}
+
+void _PROFRESET (void) {
+#ifdef PROFILE
+  prof_reset ();
+#endif
+}
+
+void _DOTPROFILE (void) { // ( n - )
+  int n = vm_pop (&vm);
+#ifdef PROFILE
+  SERIAL_LOCAL_C.print ("\r\n     count  self ");
+  SERIAL_LOCAL_C.println (prof_unit);
+  const struct prof_entry *e = 0;
+  for (int i = 0; (i < n) && (e = prof_next (e)); i++) {
+    dot_right (e->count, 10);
+    dot_right ((long) e->self, 12);
+    SERIAL_LOCAL_C.write (' ');
+    dot_cfa (e->cfa);
+    SERIAL_LOCAL_C.println ();
+  }
+  if (prof_lost) {
+    SERIAL_LOCAL_C.print ("not counted, table full: ");
+    SERIAL_LOCAL_C.println (prof_lost);
+  }
+#else
+  (void) n;
+  SERIAL_LOCAL_C.print (" not built with PROFILE ");
+#endif
+}
+
+/*  tasks - see vm.h
+
+  task_op is the operator's block, kept here rather than in
+  memory.data.  The blocks are a ring, through TASK_LINK, from the
+  operator's round to it again; a task joins it at its first
+  activate, and leaves it when forget takes it.
+
+  pause saves four registers and loads four, and the stack bounds
+  with them.  It does nothing inside a word with native code (host,
+  -n), where the machine is in the x86's registers and stack.
+*/
+
+#define KEY_WAIT   K_keywait // kernel.h
+#define PARSE_WAIT K_parsewait
+#define TASK_END   K_taskend // a task's first return
+
+int task_cur = 0;
+int task_s0 = S0, task_r0 = R0;
+static int task_op [TASK_HEAD] = { -1, 0, S0, R0, 0, 0, S0, R0 };
+
+int *task_block (int c) {
+  return c ? &memory.data [c] : task_op;
+}
+
+// is the block at c one that task made?
+boolean task_is (int c) {
+  return (c > 0) && (c < (RAM_SIZE - TASK_HEAD)) &&
+         (memory.data [c + TASK_R0] == (c + TASK_HEAD + TASK_STACK)) &&
+         (memory.data [c + TASK_S0] == (c + TASK_HEAD + (2 * TASK_STACK)));
+}
+
+// put the registers away in the running task's block, and run c
+void task_switch (int c) {
+  int *t = task_block (task_cur);
+  t [TASK_S] = vm.S; t [TASK_R] = vm.R; t [TASK_I] = vm.I; t [TASK_T] = vm.T;
+  t = task_block (c);
+  vm.S = t [TASK_S]; vm.R = t [TASK_R]; vm.I = t [TASK_I]; vm.T = t [TASK_T];
+  task_s0 = t [TASK_S0]; task_r0 = t [TASK_R0];
+  task_cur = c;
+}
+
+// a task got into the interpreter (abort, quit, a trap): it stops,
+// and the operator has the interpreter, from the top
+void task_quit (void) {
+  memory.data [task_cur + TASK_STATUS] = 0;
+  task_cur = 0;
+  task_s0 = S0;
+  task_r0 = R0;
+  vm.S = S0;
+}
+
+// forget: tasks whose blocks go are unlinked.  One that stays, but
+// would go on in code that goes, is stopped, and left at the stop
+// loop: -1 t1 ! wakes it only to stop again
+void task_forget (int h) {
+  int *prev = task_op;
+  for (int c = task_op [TASK_LINK]; c; c = memory.data [c + TASK_LINK]) {
+    if (c >= h) {
+      prev [TASK_LINK] = memory.data [c + TASK_LINK];
+      continue;
+    }
+    int *t = &memory.data [c];
+    if ((c != task_cur) && (t [TASK_I] >= h)) {
+      t [TASK_STATUS] = 0;
+      t [TASK_S] = t [TASK_S0];
+      t [TASK_R] = t [TASK_R0];
+      t [TASK_I] = TASK_END;
+      t [TASK_T] = 0;
+    }
+    prev = t;
+  }
+}
+
+void _PAUSE (void) {
+  if (NATIVE_NESTED) return;
+  int c = task_cur;
+  do {
+    c = task_block (c) [TASK_LINK];
+  } while ((c != task_cur) && !task_block (c) [TASK_STATUS]); // the operator is always awake
+  if (c != task_cur) task_switch (c);
+}
+
+void _STOP (void) { // the operator only pauses
+  if (task_cur) memory.data [task_cur + TASK_STATUS] = 0;
+  _PAUSE ();
+}
+
+void _ACTIVATE (void) { // ( a - )
+  int c = CELL_OF (vm.T);
+  _DROP ();
+  if (!task_is (c)) {
+    SERIAL_LOCAL_C.print (" not a task ");
+    return;
+  }
+  int *t = &memory.data [c];
+  boolean linked = (c == task_cur);
+  for (int x = task_op [TASK_LINK]; x && !linked; x = memory.data [x + TASK_LINK]) linked = (x == c);
+  if (!linked) {
+    t [TASK_LINK] = task_op [TASK_LINK];
+    task_op [TASK_LINK] = c;
+    seg_drop (); // task_op is not in a segment
+  }
+  t [TASK_STATUS] = -1;
+  t [TASK_S] = t [TASK_S0];
+  t [TASK_R] = t [TASK_R0] - 1;
+  memory.data [t [TASK_R]] = TASK_END;
+  t [TASK_I] = vm.I;
+  t [TASK_T] = 0;
+  if (c == task_cur) { // starting itself over
+    vm.S = t [TASK_S]; vm.R = t [TASK_R]; vm.T = t [TASK_T];
+    return;
+  }
+  _EXIT ();
+}
+
+void _TASK (void) { // task t1
+  _CREATE ();
+  int c = H;
+  for (int i = 0; i < TASK_HEAD; i++) memory.data [H++] = 0;
+  H += 2 * TASK_STACK;
+  memory.data [c + TASK_R0] = c + TASK_HEAD + TASK_STACK;
+  memory.data [c + TASK_S0] = c + TASK_HEAD + (2 * TASK_STACK);
+}
+
+// key and parse with nothing to read: into the wait in kernel.h,
+// pause and try again, until there is.  Nested into from wherever
+// they were; looped in after that
+void io_wait (int cfa) {
+  if (vm.I != (cfa + 3)) {
+    memory.data [--vm.R] = vm.I;
+    PROF_NEST (cfa, vm.R);
+  }
+  vm.I = cfa + 1;
+  io_yield = true; // the Arduino core has a turn
+}
+
+void key_wait (void) {
+  io_wait (KEY_WAIT);
+}
+
+void parse_wait (void) {
+  io_wait (PARSE_WAIT);
+}
 
 void _THROWN (void) {
-  Serial.println("TRAP thrown during autoload or elsewhere ..");
+  SERIAL_LOCAL_C.println("TRAP thrown during autoload or elsewhere ..");
+#ifdef TRACE
+  trace_dump ();
+#endif
+  SERIAL_LOCAL_C.flush ();
+  SERIAL_PORT.flush (); // out of the port too, before the hang
   while(-1); // trap
   Serial.println("NEVER SEE THIS message at LINE 1177");
 }
@@ -1232,6 +1803,60 @@ void _color_black_bg (void) {
 }
 
 
+/*  the kernel
+
+  kernel.h, read again: the compiler makes the names of the kernel
+  words into kernel_names [], and the kernel's cells, from cell 0
+  up, into kernel_image [].  Addresses and links are counted from
+  the order of the lines.  setup () copies the cells into
+  memory.data - words are run, and may be written to, there (fuse
+  is a variable).  The kernel takes its KERNEL_H cells of SRAM, as
+  it did when setup () built it; the names stay in flash.
+*/
+
+#define CODE(t, p)
+#define WORD(t, f, s, p) { KN_##t, (s) },
+#define PRIM(p)
+#define CODE_OF(t, p)
+#define WORD_OF(t, f, s, p) { KN_##t, (s) },
+#define LABEL(t)
+#define DATA(v)
+
+constexpr struct kernel_name kernel_names [] = {
+#include "kernel.h"
+};
+
+#define CODE(t, p)
+#define WORD(t, f, s, p) N_##t,
+#define PRIM(p)
+#define CODE_OF(t, p)
+#define WORD_OF(t, f, s, p) N_##t,
+#define LABEL(t)
+#define DATA(v)
+
+enum { // each word's place among the names
+#include "kernel.h"
+  KERNEL_NAMED };
+
+#define KERNEL_LINK(n) (((n) > 0) ? kernel_names [(n) - 1].a : 0) // the word named before
+
+#define CODE(t, p) P##p,
+#define WORD(t, f, s, p) NAME_KEY (s) | (f), KERNEL_LINK (N_##t), P##p,
+#define PRIM(p)
+#define CODE_OF(t, p) P##p,
+#define WORD_OF(t, f, s, p) NAME_KEY (s) | (f), KERNEL_LINK (N_##t), P##p,
+#define LABEL(t)
+#define DATA(v) (v),
+
+constexpr int kernel_image [] = { 0, // cell 0
+#include "kernel.h"
+};
+
+static_assert (sizeof (kernel_image) / sizeof (kernel_image [0]) == KERNEL_H, "kernel.h: the cells and K_ disagree");
+
+const int kernel_named = KERNEL_NAMED;
+constexpr int KERNEL_D = kernel_names [KERNEL_NAMED - 1].a; // latest
+
 void setup () {
 #ifdef HAS_DOTSTAR_LIB
   setup_dotstar(); // turn off dotstar (apa-102 RGB LED)
@@ -1241,611 +1866,14 @@ void setup () {
 
   // SERIAL_LOCAL_C.begin (38400); while (!SERIAL_LOCAL_C);
 
-  S = S0; // initialize data stack
-  R = R0; // initialize return stack
-
-  // initialize dictionary
-
-  // unlinked primitives
-  CODE(1, _LIT)
-#  define lit 1
-  CODE(2, _BRANCH)
-#  define branch 2
-  CODE(3, _0BRANCH)
-#  define zbranch 3
-  CODE(4, _DO)
-#  define ddo 4
-  CODE(5, _LOOP)
-#  define lloop 5
-  CODE(6, _INITR)
-#  define initr 6
-  CODE(7, _INITS)
-#  define inits 7
-  CODE(8, _SHOWTIB)
-#  define showtib 8
-  CODE(9, _OK)
-#  define ok 9
-  // room to expand here
-
-  // trailing space kludge
-  NAME(20, 0, 0, 10, 0, 0)
-  LINK(21, 0)
-  CODE(22, _NOP)
-#define nop 22
-  // exit
-  NAME(23, 0, 4, 'e', 'x', 'i')
-  LINK(24, 20)
-  CODE(25, _EXIT)
-#  define exit 25
-  // key ( - c)
-  NAME(26, 0, 3, 'k', 'e', 'y')
-  LINK(27, 23)
-  CODE(28, _KEY)
-  // emit ( c - )
-  NAME(29, 0, 4, 'e', 'm', 'i')
-  LINK(30, 26)
-  CODE(31, _EMIT)
-#  define emit 31
-  // cr
-  NAME(32, 0, 2, 'c', 'r', 0)
-  LINK(33, 29)
-  CODE(34, _CR)
-#  define cr 34
-  // parse // leaves string in tib
-  NAME(35, 0, 5, 'p', 'a', 'r')
-  LINK(36, 32)
-  CODE(37, _PARSE)
-#  define parse 37
-  // word ( - n) gets string from tib
-  NAME(38, 0, 4, 'w', 'o', 'r')
-  LINK(39, 35)
-  CODE(40, _WORD)
-#  define wword 40
-  // dup ( n - n n)
-  NAME(41, 0, 3, 'd', 'u', 'p')
-  LINK(42, 38)
-  CODE(43, _DUP)
-#  define dup 43
-  // drop ( n - )
-  NAME(44, 0, 4, 'd', 'r', 'o')
-  LINK(45, 41)
-  CODE(46, _DROP)
-#  define drop 46
-  // swap ( n1 n2 - n2 n1)
-  NAME(47, 0, 4, 's', 'w', 'a')
-  LINK(48, 44)
-  CODE(49, _SWAP)
-#  define swap 49
-  // over ( n1 n2 - n1 n2 n1)
-  NAME(50, 0, 4, 'o', 'v', 'e')
-  LINK(51, 47)
-  CODE(52, _OVER)
-#  define over 52
-  // @ ( a - n)
-  NAME(53, 0, 1, '@', 0, 0)
-  LINK(54, 50)
-  CODE(55, _FETCH)
-  // ! ( n a - )
-  NAME(56, 0, 1, '!', 0, 0)
-  LINK(57, 53)
-  CODE(58, _STORE)
-  // , ( n - )
-  NAME(59, 0, 1, ',', 0, 0)
-  LINK(60, 56)
-  CODE(61, _COMMA)
-  // find ( n - a)
-  NAME(62, 0, 4, 'f', 'i', 'n')
-  LINK(63, 59)
-  CODE(64, _FIND)
-#  define find 64
-  // execute ( a)
-  NAME(65, 0, 7, 'e', 'x', 'e')
-  LINK(66, 62)
-  CODE(67, _EXECUTE)
-#  define execute 67
-  // ?dup ( n - 0 | n n)
-  NAME(68, 0, 3, '?', 'd', 'u')
-  LINK(69, 65)
-  CODE(70, _QDUP)
-#  define qdup 70
-  // number ( - n -f) gets string from tib
-  NAME(71, 0, 6, 'n', 'u', 'm')
-  LINK(72, 68)
-  CODE(73, _NUMBER)
-#  define number 73
-  // depth ( - n)
-  NAME(74, 0, 5, 'd', 'e', 'p')
-  LINK(75, 71)
-  CODE(76, _DEPTH)
-#  define depth 76
-  // 0< ( n - f)
-  NAME(77, 0, 2, '0', '<', 0)
-  LINK(78, 74)
-  CODE(79, _ZEROLESS)
-#  define zeroless 79
-
-/*
-
-abort:
-
-  1. _NEST
-  2. inits
-  3. branch 89, which ..
-  4. initr
-     .. while skipping over the second _NEST at position 88
-  5. parse wword find qdup zbranch .. lost
-
-  So 5.) should be the call to _FLOAD (as fload #define really a number).
-    Any #define near NAME-LINK-CODE's points to CODE not NAME.
-    have defined fload for 467 so use the define(macro).
-  5. fload
-
-*/
-  // abort
-  NAME(80, 0, 5, 'a', 'b', 'o')
-  LINK(81, 77)
-  CODE(82, _NEST)
-  DATA(83, inits)
-#  define abort 83
-  // again
-  DATA(84, branch)
-  DATA(85, 89)
-  // quit
-  NAME(86, 0, 4, 'q', 'u', 'i')
-  LINK(87, 77)
-  CODE(88, _NEST)
-  DATA(89, initr)
-  // begin quit loop
-  DATA(90, parse)
-  DATA(91, wword)
-  DATA(92, find)
-  DATA(93, qdup)
-  DATA(94, zbranch)
-  DATA(95, 103) // to number
-  DATA(96, execute)
-  DATA(97, depth)
-  DATA(98, zeroless)
-  DATA(99, zbranch)
-  DATA(100, 114) // to ok
-  DATA(101, branch)
-  DATA(102, 106)
-  DATA(103, number)
-  DATA(104, zbranch)
-  DATA(105, 114) // to ok
-  DATA(106, nop) // tnr, suppressed with a nop // DATA(106, showtib)
-  DATA(107, lit)
-  DATA(108, '?')
-  DATA(109, emit)
-  DATA(110, cr)
-  DATA(111, inits)
-  DATA(112, branch) // most operands for control structures have the branch dest after 'branch' or 'lloop'.
-  DATA(113, 89)
-  DATA(114, ok)
-  DATA(115, branch)
-  DATA(116, 90) // continue quit loop
-
-  // a 'branch' points to a 'DATA' statement
-
-  // - - - - -   large  gap  here   - - - - -
-
-  // flparse // leaves string in tib
-  NAME(135, 0, 7, 'f', 'l', 'p')
-  LINK(136, 86)
-  CODE(137, _FLPARSE)
-#  define flparse 137
-
-  // sfparse // leaves string in tib
-  NAME(138, 0, 7, 's', 'f', 'p')
-  LINK(139, 135)
-  CODE(140, _SFPARSE)
-#  define sfparse 140
-
-
-  // flabort
-  NAME(180, 0, 7, 'f', 'l', 'a')
-  LINK(181, 77)
-  CODE(182, _NEST)
-  DATA(183, inits)
-#  define flabort 183
-  // fload loop - again
-  DATA(184, branch)
-  DATA(185, 189)
-  // bye - seems ignored
-  NAME(186, 0, 3, 'b', 'y', 'e')
-  LINK(187, 77) // 0< - may be the same entry point
-  CODE(188, _NEST)
-  DATA(189, initr)
-  // begin quit loop
-  DATA(190, flparse) // latest change
-  DATA(191, wword) // gets string from tib
-  DATA(192, find)
-  DATA(193, qdup)
-  DATA(194, zbranch)
-  DATA(195, 203) // to number
-  DATA(196, execute)
-  DATA(197, depth)
-  DATA(198, zeroless)
-  DATA(199, zbranch)
-  DATA(200, 214) // to ok
-  DATA(201, branch)
-  DATA(202, 206)
-  DATA(203, number)
-  DATA(204, zbranch)
-  DATA(205, 214) // to ok
-  DATA(206, nop) // tnr, suppressed with a nop // DATA(106, showtib)
-  DATA(207, lit)
-  DATA(208, '~') // was '?' in the original
-  DATA(209, emit)
-  DATA(210, cr)
-  DATA(211, inits)
-  DATA(212, branch)
-  DATA(213, 189)
-  DATA(214, ok)
-  DATA(215, branch)
-  DATA(216, 190) // continue quit loop
-
-
-
-
-
-  // sfabort
-  NAME(280, 0, 7, 's', 'f', 'a')
-  LINK(281, 77)
-  CODE(282, _NEST)
-  DATA(283, inits)
-#  define sfabort 283
-  // sfload loop - again
-  DATA(284, branch)
-  DATA(285, 289)
-  // alhoa - seems ignored
-  NAME(286, 0, 5, 'a', 'l', 'o')
-  LINK(287, 77) // 0< - may be the same entry point
-  CODE(288, _NEST)
-  DATA(289, initr)
-  // begin local sfparse quit loop
-  DATA(290, sfparse) // latest change - - - - - - - - - - - - - - - -
-
-  // sfparse does nothing, now . . .  02 SEP 2019
-
-  DATA(291, branch)
-  DATA(292, 290) // continue the local quit loop
-
-  // above truncates progress of this definition. 02 SEP 2019
-
-/*
-  DATA(291, wword) // gets string from tib
-  DATA(292, find)
-*/
-
-// extra cruft leftover:
-
-  DATA(293, qdup)
-  DATA(294, zbranch)
-  DATA(295, 303) // to number
-  DATA(296, execute)
-  DATA(297, depth)
-  DATA(298, zeroless)
-  DATA(299, zbranch)
-  DATA(300, 314) // to ok
-  DATA(301, branch)
-  DATA(302, 306)
-  DATA(303, number)
-  DATA(304, zbranch)
-  DATA(305, 314) // to ok
-  DATA(306, nop) // tnr, suppressed with a nop // DATA(106, showtib)
-  DATA(307, lit)
-  DATA(308, '!') // was '~' in the recent copy of the original
-  DATA(309, emit)
-  DATA(310, cr)
-  DATA(311, inits)
-  DATA(312, branch)
-  DATA(313, 289)
-  DATA(314, ok)
-
-
-  DATA(315, branch)
-  DATA(316, 290) // continue quit loop
-
-// <<-- extra cruft leftover  02 SEP 2019
-
-
-  // . ( n - )
-  NAME(317, 0, 1, '.', 0, 0)
-  LINK(318, 138) // 135 // 86 // if this isn't 86 then the quit word is lost -- old: NEAT - links back to the quit word here
-  CODE(319, _DOT)
-#  define dot 319
-  // .s
-  NAME(320, 0, 2, '.', 's', 0)
-  LINK(321, 317)
-  CODE(322, _DDOTS)
-#  define ddots 322
-  // words
-  NAME(323, 0, 5, 'w', 'o', 'r')
-  LINK(324, 320)
-  CODE(325, _WORDS)
-#  define words 325
-  // space
-  NAME(326, 0, 5, 's', 'p', 'a')
-  LINK(327, 323)
-  CODE(328, _SPACE)
-#  define space 328
-  // h. ( n - )
-  NAME(329, 0, 2, 'h', '.', 0)
-  LINK(330, 326)
-  CODE(331, _HDOT)
-#  define hdot 331
-  // + ( n1 n2 - n3)
-  NAME(332, 0, 1, '+', 0, 0)
-  LINK(333, 329)
-  CODE(334, _PLUS)
-#  define plus 334
-  // - ( n1 n2 - n3)
-  NAME(335, 0, 1, '-', 0, 0)
-  LINK(336, 332)
-  CODE(337, _MINUS)
-  // and (n1 n2 - n3)
-  NAME(338, 0, 3, 'a', 'n', 'd')
-  LINK(339, 335)
-  CODE(340, _aND)
-  // or ( n1 n2 - n3)
-  NAME(341, 0, 2, 'o', 'r', 0)
-  LINK(342, 338)
-  CODE(343, _OR)
-  // xor ( n1 n2 - n3)
-  NAME(344, 0, 3, 'x', 'o', 'r')
-  LINK(345, 341)
-  CODE(346, _XOR)
-  // invert ( n1 - n2)
-  NAME(347, 0, 6, 'i', 'n', 'v')
-  LINK(348, 344)
-  CODE(349, _INVERT)
-  // abs ( n1 - n2)
-  NAME(350, 0, 3, 'a', 'b', 's')
-  LINK(351, 347)
-  CODE(352, _ABS)
-  // negate ( n1 - n2)
-  NAME(353, 0, 6, 'n', 'e', 'g')
-  LINK(354, 350)
-  CODE(355, _NEGATE)
-  // 2* ( n1 - n2)
-  NAME(356, 0, 2, '2', '*', 0)
-  LINK(357, 353)
-  CODE(358, _TWOSTAR)
-  // 2/ ( n1 - n2)
-  NAME(359, 0, 2, '2', '/', 0)
-  LINK(360, 356)
-  CODE(361, _TWOSLASH)
-  // dump ( a n - a+n) 
-  NAME(362, 0, 4, 'd', 'u', 'm')
-  LINK(363, 359)
-  CODE(364, _DUMP)
-  // create
-  NAME(365, 0, 6, 'c', 'r', 'e')
-  LINK(366, 362)
-  CODE(367, _CREATE)
-  // here 
-  NAME(368, 0, 4, 'h', 'e', 'r')
-  LINK(369, 365)
-  CODE(370, _HERE)
-  // allot 
-  NAME(371, 0, 5, 'a', 'l', 'l')
-  LINK(372, 368)
-  CODE(373, _ALLOT)
-  // variable 
-  NAME(374, 0, 8, 'v', 'a', 'r')
-  LINK(375, 371)
-  CODE(376, _VARIABLE)
-  // ?
-  NAME(377, 0, 1, '?', 0, 0)
-  LINK(378, 374)
-  CODE(379, _QUESTION)
-  // constant
-  NAME(380, 0, 8, 'c', 'o', 'n')
-  LINK(381, 377)
-  CODE(382, _CONSTANT)
-  // R
-  NAME(383, 0, 1, 'R', 0, 0)
-  LINK(384, 380)
-  CODE(385, _R)
-  // [ 
-  NAME(386, IMMED, 1, '[', 0, 0)
-  LINK(387, 383)
-  CODE(388, _LBRAC)
-  // ]
-  NAME(389, 0, 1, ']', 0, 0)
-  LINK(390, 386)
-  CODE(391, _RBRAC)
-  // :
-  NAME(392, 0, 1, ':', 0, 0)
-  LINK(393, 389)
-  CODE(394, _COLON)
-  // ;
-  NAME(395, IMMED, 1, ';', 0, 0)
-  LINK(396, 392)
-  CODE(397, _SEMI)
-  // i 
-  NAME(398, 0, 1, 'i', 0, 0)
-  LINK(399, 395)
-  CODE(400, _I)
-#  define _i 400
-  // do
-  NAME(401, IMMED, 2, 'd', 'o', 0)
-  LINK(402, 398)
-  CODE(403, _CDO)
-  // loop 
-  NAME(404, IMMED, 4, 'l', 'o', 'o')
-  LINK(405, 401)
-  CODE(406, _CLOOP)
-  // begin 
-  NAME(407, IMMED, 5, 'b', 'e', 'g')
-  LINK(408, 404)
-  CODE(409, _CBEGIN)
-  // until 
-  NAME(410, IMMED, 5, 'u', 'n', 't')
-  LINK(411, 407)
-  CODE(412, _CUNTIL)
-  // if
-  NAME(413, IMMED, 2, 'i', 'f', 0)
-  LINK(414, 410)
-  CODE(415, _CIF)
-  // then
-  NAME(416, IMMED, 4, 't', 'h', 'e')
-  LINK(417, 413)
-  CODE(418, _CTHEN)
-  // else
-  NAME(419, IMMED, 4, 'e', 'l', 's')
-  LINK(420, 416)
-  CODE(421, _CELSE)
-  // forget
-  NAME(422, 0, 6, 'f', 'o', 'r')
-  LINK(423, 419)
-  CODE(424, _FORGET)
-  // '
-  NAME(425, 0, 1, '\'', 0, 0)
-  LINK(426, 422)
-  CODE(427, _TICK)
-  // again
-  NAME(428, IMMED, 5, 'a', 'g', 'a')
-  LINK(429, 425)
-  CODE(430, _CAGAIN)
-  // while
-  NAME(431, IMMED, 5, 'w', 'h', 'i')
-  LINK(432, 428)
-  CODE(433, _CWHILE)
-  // repeat
-  NAME(434, IMMED, 6, 'r', 'e', 'p')
-  LINK(435, 431)
-  CODE(436, _CREPEAT)
-  // literal 
-  NAME(437, IMMED, 7, 'l', 'i', 't')
-  LINK(438, 434)
-  CODE(439, _CLITERAL)
-  // c@ ( b - c) 
-  NAME(440, 0, 2, 'c', '@', 0)
-  LINK(441, 437)
-  CODE(442, _CFETCH)
-#  define cfetch 442
-  // c! ( c b - ) 
-  NAME(443, 0, 2, 'c', '!', 0)
-  LINK(444, 440)
-  CODE(445, _CSTORE)
-  // type ( b c - ) 
-  NAME(446, 0, 4, 't', 'y', 'p')
-  LINK(447, 443)
-  CODE(448, _NEST)
-  DATA(449, over)
-  DATA(450, plus)
-  DATA(451, swap)
-  DATA(452, ddo)
-  DATA(453, _i)
-  DATA(454, cfetch)
-  DATA(455, emit)
-  DATA(456, lloop)
-  DATA(457, 453)
-  DATA(458, exit)
-  // warm (  - )
-  NAME(459, 0, 4, 'w', 'a', 'r')
-  LINK(460, 446)
-  CODE(461, _WARM)
-
-  // wlist (  - )
-  NAME(462, 0, 5, 'w', 'l', 'i')
-  LINK(463, 459)
-  CODE(464, _WLIST)
-
-  // fload (  - )
-  NAME(465, 0, 5, 'f', 'l', 'o')
-  LINK(466, 462)
-  CODE(467, _FLOAD)
-  #define fload 467
-
-// wag (  - )
-  NAME(468, 0, 3, 'w', 'a', 'g')
-  LINK(469, 465)
-  CODE(470, _WAGDS)
-
-// wiggle ( n  - )
-  NAME(471, 0, 6, 'w', 'i', 'g')
-  LINK(472, 468)
-  CODE(473, _WIGGLE)
-
-// rbyte ( adrs - n ) // consumes an address and returns a byte stored at that address
-  NAME(474, 0, 5, 'r', 'b', 'y')
-  LINK(475, 471) // patch that hole
-  CODE(476, _RBYTE)
-
-// compose (  - )
-  NAME(477, 0, 2, 'c', 'c', 0) // named as the 'cc' word for now - was 'compose' too long to type blind
-  LINK(478, 474)
-  CODE(479, _COMPOSE)
-
-// s" ( -- addr )
-// length is found by another method.
-// squot squote s_quot s_quote _SQUOT _SQUOTE
-// gstr (  -- addr ) // get string
-  NAME(480, 0, 2, 's', '"', 0) 
-  LINK(481, 477)
-  CODE(482, _GETSTR)
-
-// fs@ ( addr -- )
-// fs@  (  - ) // fetch string
-  NAME(483, 0, 3, 'f', 's', '@')
-  LINK(484, 480)
-  CODE(485, _FETCHSTR)
-
-// cpmem ( addr ln - )
-  NAME(486, 0, 5, 'c', 'p', 'm')
-  LINK(487, 483)
-  CODE(488, _COPYMEM)
-
-  NAME(489, 0, 5, 't', 'h', 'r') // throw
-  LINK(490, 486)
-  CODE(491, _THROWN)
-  #define thrown 491
-
-  // code of 'type' subst. for real autoload aka 'uol' ( b c - ) 
-
-// branch 89 90 106 seen
-// I=83; I=190; I=83;
-// 190 calls flparse and is probably the correct entry point,
-// perhaps after a setup.
-
-  NAME(492, 0, 3, 'u', 'o', 'l') // 'uol' autoload
-  LINK(493, 489)
-  CODE(494, _NOP)
-  DATA(495, inits)
-  DATA(496, initr)
-  DATA(497, fload)
-  DATA(498, thrown)
-  #define autoload 495
-
-// new 05 sep
-// pmd pnw
-  NAME(499, 0, 6, 'p', 'n', 'm') // 'pnmode' pinMode word
-  LINK(500, 492)
-  CODE(501, _PINMODE)
-
-  NAME(502, 0, 7, 'p', 'n', 'w') // 'pnwrite' pinMode word
-  LINK(503, 499)
-  CODE(504, _PINWRITE)
-
-  // test
-  DATA(600, lit)
-  DATA(601, 10) // i
-  DATA(602, lit)
-  DATA(603, 0) // i
-  DATA(604, ddo)
-  DATA(605, 400) // i // does not change when the century (400, 500, 600) changes
-  DATA(606, dot)
-  DATA(607, lloop)
-  DATA(608, 605) // this slaves to current address block
-  DATA(609, 385) // R // also does not change with the rest of them
-  DATA(610, dot)
-  DATA(611, ddots)
-  DATA(612, cr)
-  DATA(613, branch)
-  DATA(614, 600) // return to top of this code block
+  vm.S = S0; // initialize data stack
+  vm.R = R0; // initialize return stack
 
+  // initialize dictionary - kernel.h, by way of kernel_image []
+  memcpy (memory.data, kernel_image, sizeof (kernel_image));
+  D = KERNEL_D; // latest word
+  H = KERNEL_H; // top of dictionary (here)
+  guard_fill ();
 
   // D = 486; // previous latest word ('cpmem') before 'uol' was added
   // H = 489; // previous top of dictionary (just past 'cpmem')
@@ -1853,8 +1881,14 @@ abort:
   // D = 492;
   // H = 499; // longer offset than usual
 
-     D = 502; // latest word
-     H = 505; // top of dictionary (here)
+  // D = 502;
+  // H = 505;
+
+  // D = 505;
+  // H = 509;
+
+  dict_rehash ();
+  image_kernel (); // src/image.cpp
 
 // cpmem 486 thru 488, 489 is 488 + 1
 
@@ -1871,9 +1905,18 @@ abort:
 #else
    SERIAL_LOCAL_C.print(" +AUL ");
 #endif // #ifdef VERBIAGE_AA
-   I = autoload;
+   vm.I = K_autoload;
+   SERIAL_LOCAL_C.flush (); // image_load () writes to the port itself
+   if (image_load ()) { // saved by save-image, from this boot file
+#ifdef VERBIAGE_AA
+     SERIAL_LOCAL_C.println(" the dictionary was restored from " IMAGE_NAME " - no autoload. ");
+#else
+     SERIAL_LOCAL_C.print(" +IMG ");
+#endif // #ifdef VERBIAGE_AA
+     vm.I = K_abort;
+   }
 #else
-   I = abort;
+   vm.I = K_abort;
    Serial.println("DEBUG: _AUTOLOAD() not active.  I = abort.");
 #endif
 
@@ -1914,25 +1957,297 @@ abort:
 
 */
 
+// code field cells -> primitives, in kernel.h order, as vm.h numbers them
+#define CODE(t, p) p,
+#define WORD(t, f, s, p) p,
+#define PRIM(p) p,
+#define CODE_OF(t, p)
+#define WORD_OF(t, f, s, p)
+#define LABEL(t)
+#define DATA(v)
+
+const prim_t prim_table [PRIM_COUNT] = { _THROWN,
+#include "kernel.h"
+};
+
+// number of a primitive, for a code field - setup time, mostly
+int prim_cell (prim_t a) {
+  for (int i = 1; i < PRIM_COUNT; i++) {
+    if (prim_table [i] == a) return i;
+  }
+  return P_NONE;
+}
+
+/*  superinstructions
+
+  _COMPILE lays down one instruction in a colon definition.  When
+  it and the one before it make a pair in fusions [] the two are
+  replaced by a single instruction that does the work of both.  A
+  fused instruction may fuse again with the next, so three or four
+  words can end up as one dispatch.  A lit keeps its number in
+  line; the fused instruction reads it just as lit would.
+
+  Only instructions laid down by _COMPILE, one right after the
+  other, are fused.  An immediate word (if then begin do ..) might
+  leave a branch target between them, so running one starts over.
+
+    0 fuse !    compile everything as written
+   -1 fuse !    fuse (the default)
+*/
+
+struct fusion {
+  int first; // code field of the first word
+  int next;  // and of the word after it
+  int fused; // code field that replaces the pair
+};
+
+const struct fusion fusions [] = {
+  { K_over,         K_over,       K_overover },          // over over
+  { K_overover,     K_minus,      K_overoverminus },     // over over -
+  { K_overover,     K_swap,       K_overoverswap },      // over over swap
+  { K_overoverswap, K_minus,      K_overoverswapminus }, // over over swap -
+  { K_dup,          K_fetch,      K_dupfetch },          // dup @
+  { K_swap,         K_drop,       K_swapdrop },          // swap drop
+  { K_lit,          K_plus,       K_litplus },           // n +
+  { K_lit,          K_minus,      K_litminus },          // n -
+  { K_lit,          K_aand,       K_litand },            // n and
+  { K_minus,        K_zeroless,   K_minuszeroless },     // - 0<
+};
+
+#define FUSIONS (sizeof (fusions) / sizeof (fusions [0]))
+
+// compile ( a - ) the code field a, as one instruction
+void _COMPILE (void) {
+  int op = vm.T;
+  if (H != fuse_h) fuse_at [1] = -1; // something else was compiled
+  fuse_at [0] = fuse_at [1];
+  fuse_at [1] = H;
+  _COMMA ();
+  fuse_h = (op == K_lit) ? (H + 1) : H; // lit: just past its number
+  if (!memory.data [K_fuse + 1] || (fuse_at [0] < 0)) return;
+  int a = memory.data [fuse_at [0]];
+  int b = memory.data [fuse_at [1]];
+  for (unsigned int i = 0; i < FUSIONS; i++) {
+    if ((fusions [i].first == a) && (fusions [i].next == b)) {
+      memory.data [fuse_at [0]] = fusions [i].fused;
+      H = fuse_at [1]; // any number lit had stays where it was
+      fuse_at [1] = fuse_at [0];
+      fuse_at [0] = -1;
+      fuse_h = H;
+      return;
+    }
+  }
+}
+
+// the guards between the regions (vm.h), GUARD_CELLS each
+static const int guard_at [] = { DICT_CELLS, R0, S0 };
+
+void guard_fill (void) {
+  for (int g = 0; g < 3; g++)
+    for (int i = 0; i < GUARD_CELLS; i++) memory.data [guard_at [g] + i] = GUARD_FILL;
+}
+
+// the first guard cell written over, or 0
+int guard_broken (void) {
+  for (int g = 0; g < 3; g++)
+    for (int i = 0; i < GUARD_CELLS; i++)
+      if (memory.data [guard_at [g] + i] != GUARD_FILL) return guard_at [g] + i;
+  return 0;
+}
+
+#ifdef MEM_CHECKED
+/*  checked memory access - see vm.h
+
+  mem_trap () reports the first thing out of range; vm_run sees
+  mem_trapped at the end of the instruction, and calls vm_trap (),
+  which goes to abort.
+*/
+
+int mem_trapped = 0;
+static int mem_spare; // where a store out of range goes
+
+void mem_trap (const char *what, int n) {
+  if (mem_trapped) return;
+  mem_trapped = -1;
+  SERIAL_LOCAL_C.print ("\r\ntrap: ");
+  SERIAL_LOCAL_C.print (what);
+  SERIAL_LOCAL_C.print (" ");
+  SERIAL_LOCAL_C.print (n);
+}
+
+int &mem_cell_out (int c) {
+  mem_trap ("address", c * 4);
+  mem_spare = 0;
+  return mem_spare;
+}
+
+unsigned char &mem_byte_out (int a) {
+  mem_trap ("address", a);
+  mem_spare = 0;
+  return *(unsigned char *) &mem_spare;
+}
+
+// after an instruction: a trapped access, or a stack pointer gone
+// out of its stack.  Report it, and abort
+void vm_trap (void) {
+  if (vm.S > task_s0) mem_trap ("data stack underflow, depth", task_s0 - vm.S);
+  if (vm.S <= S_FLOOR) mem_trap ("data stack overflow, depth", task_s0 - vm.S);
+  if (vm.R > task_r0) mem_trap ("return stack underflow, depth", task_r0 - vm.R);
+  if (vm.R <= R_FLOOR) mem_trap ("return stack overflow, depth", task_r0 - vm.R);
+  int g = guard_broken ();
+  if (g) mem_trap ("guard written over, at", g * 4);
+  if (H > DICT_CELLS) { // the dictionary ran into the guard: it stays full
+    H = DICT_CELLS;
+    while (D >= DICT_CELLS) D = memory.data [D + 1];
+    dict_rehash ();
+  }
+  if (g) guard_fill ();
+  SERIAL_LOCAL_C.print (", next instruction at ");
+  SERIAL_LOCAL_C.println (vm.I);
+#ifdef TRACE
+  trace_dump ();
+#endif
+  mem_trapped = 0;
+  seg_drop ();
+  if (task_cur) task_quit ();
+  vm.S = S0;
+  vm.R = R0;
+  vm.I = K_abort;
+}
+#endif // #ifdef MEM_CHECKED
+
+// inner interpreter: run up to budget instructions, or until
+// a word that waited on the keyboard asks for the Arduino core
+// to have a turn.  Returns the number of instructions run.
+
+// The registers live in locals here, so the compiler can keep
+// them in machine registers.  The common primitives are done
+// in line, on those locals; any other primitive is called with
+// the registers written back to vm, and they are read back
+// afterward.  Each case below does what the primitive of the
+// same name does.
+
+#define DUP_  memory.data [--S] = T
+#define DROP_ T = memory.data [S++]
+
+int vm_run (int budget) {
+  int S = vm.S, R = vm.R, I = vm.I, W = vm.W, T = vm.T;
+  int n = 0;
+  io_yield = false;
+  while (n < budget) {
+    W = memory.data [I++]; // Read the instruction (an ordinary integer)
+                           // stored at the location in the memory.data array
+                           // pointed to by the Instruction Pointer, I
+                           // and store it in the Working register, W --
+                           // and (only afterward) increment I by one.
+
+    n++;
+    TRACE_STEP (I - 1, W, T, S, R);
+    PROF_COUNT (W);
+    switch (memory.data [W]) { // Execute program stored at location W.
+    case P_NOP:                                                    break;
+    case P_LIT:      DUP_; T = memory.data [I++];                  break;
+    case P_BRANCH:   I = memory.data [I];                          break;
+    case P_0BRANCH:  I = (T == 0) ? memory.data [I] : (I + 1);
+                     DROP_;                                        break;
+    case P_DO:       memory.data [--R] = T - memory.data [S]; DROP_;
+                     memory.data [--R] = T; DROP_;                 break;
+    case P_LOOP:
+      if (++memory.data [R + 1]) {
+        I = memory.data [I];
+        break;
+      }
+      R += 2; I += 1;                                              break;
+    case P_PLOOP: {
+      int X = memory.data [R + 1];
+      W = T; DROP_;
+      int Y = (int) ((unsigned int) X + W);
+      memory.data [R + 1] = Y;
+      if (((X ^ Y) >= 0) || ((X ^ W) >= 0)) {
+        I = memory.data [I];
+        break;
+      }
+      R += 2; I += 1;                                              break;
+    }
+    case P_LEAVE:    R += 2; I = memory.data [I];                  break;
+    case P_UNLOOP:   R += 2;                                       break;
+    case P_I:        DUP_; T = memory.data [R + 1] + memory.data [R]; break;
+    case P_J:        DUP_; T = memory.data [R + 3] + memory.data [R + 2]; break;
+    case P_R:        DUP_; T = R * 4;                              break;
+    case P_EXIT:     PROF_EXIT (R); I = memory.data [R++];         break;
+    case P_NEST:
+#ifdef HOST_NATIVE
+      if (native_entry [W]) {
+        vm.S = S; vm.R = R; vm.I = I; vm.W = W; vm.T = T;
+        native_call (W);
+        S = vm.S; R = vm.R; T = vm.T;
+        break;
+      }
+#endif // #ifdef HOST_NATIVE
+      memory.data [--R] = I; I = (W + 1); PROF_NEST (W, R);        break;
+    case P_DOVAR:    DUP_; T = (W + 1) * 4;                        break;
+    case P_DOCONST:  DUP_; T = memory.data [W + 1];                break;
+    case P_DUP:      DUP_;                                         break;
+    case P_DROP:     DROP_;                                        break;
+    case P_QDUP:     if (T) DUP_;                                  break;
+    case P_SWAP:     W = memory.data [S]; memory.data [S] = T; T = W; break;
+    case P_OVER:     DUP_; T = memory.data [S + 1];                break;
+    case P_FETCH:    T = MEM_CELL (CELL_OF (T));                   break;
+    case P_STORE:    W = CELL_OF (T); DROP_; MEM_CELL (W) = T; DROP_;
+                     NATIVE_STORED (W);                            break;
+    case P_CFETCH:   T = MEM_BYTE (T);                             break;
+    case P_CSTORE:   W = T; DROP_; MEM_BYTE (W) = T; DROP_;
+                     NATIVE_STORED (CELL_OF (W));                  break;
+    case P_COMMA:    memory.data [H++] = T; DROP_;                 break;
+    case P_PLUS:     W = T; DROP_; T = (T + W);                    break;
+    case P_MINUS:    W = T; DROP_; T = (T - W);                    break;
+    case P_aND:      W = T; DROP_; T = (T & W);                    break;
+    case P_OR:       W = T; DROP_; T = (T | W);                    break;
+    case P_XOR:      W = T; DROP_; T = (T ^ W);                    break;
+    case P_INVERT:   T = ~T;                                       break;
+    case P_NEGATE:   T = -T;                                       break;
+    case P_ABS:      T = abs (T);                                  break;
+    case P_TWOSTAR:  T = (T << 1);                                 break;
+    case P_TWOSLASH: T = (T >> 1);                                 break;
+    case P_ZEROLESS: T = (T < 0) ? -1 : 0;                         break;
+    case P_DEPTH:    W = task_s0 - S; DUP_; T = W;                 break;
+    case P_OVEROVER: DUP_; T = memory.data [S + 1];
+                     DUP_; T = memory.data [S + 1];                break;
+    case P_OVEROVERMINUS:     DUP_; T = memory.data [S + 1] - T;   break;
+    case P_OVEROVERSWAP:      DUP_; DUP_; T = memory.data [S + 2]; break;
+    case P_OVEROVERSWAPMINUS: DUP_; T = T - memory.data [S + 1];   break;
+    case P_DUPFETCH: DUP_; T = MEM_CELL (CELL_OF (T));             break;
+    case P_SWAPDROP: S++;                                          break;
+    case P_LITPLUS:  T += memory.data [I++];                       break;
+    case P_LITMINUS: T -= memory.data [I++];                       break;
+    case P_LITAND:   T &= memory.data [I++];                       break;
+    case P_MINUSZEROLESS: W = T; DROP_; T = ((T - W) < 0) ? -1 : 0; break;
+    default: // everything else: out of line, on vm
+      vm.S = S; vm.R = R; vm.I = I; vm.W = W; vm.T = T;
+      CELL_FN (memory.data [W]) (); // out of range: _THROWN
+      S = vm.S; R = vm.R; I = vm.I; W = vm.W; T = vm.T;
+    }
+#ifdef MEM_CHECKED
+    if (mem_trapped || (S > task_s0) || (S <= S_FLOOR) || (R > task_r0) || (R <= R_FLOOR) ||
+        (memory.data [DICT_CELLS] != GUARD_FILL)) { // the dictionary's end
+      vm.S = S; vm.R = R; vm.I = I; vm.W = W; vm.T = T;
+      vm_trap ();
+      S = vm.S; R = vm.R; I = vm.I; W = vm.W; T = vm.T;
+    }
+#endif // #ifdef MEM_CHECKED
+    if (io_yield) break;
+  }
+  vm.S = S; vm.R = R; vm.I = I; vm.W = W; vm.T = T;
+  return n;
+}
+
+#undef DUP_
+#undef DROP_
+
 // the loop function runs over and over again forever
 void loop() {
-  W = memory.data [I++]; // Read the instruction (an ordinary integer)
-                         // stored at the location in the memory.data array
-                         // pointed to by the Instruction Pointer, I
-                         // and store it in the Working register, W --
-                         // and (only afterward) increment I by one.
-
-                         // So: only copy an integer out of an array and
-                         // into a singlton int (W in this case), and
-                         // then increment an integer (I).  That's it.
-
-  memory.program [W] (); // Execute program stored at location W.  This
-                         // is the only time the Virtual Machine takes
-                         // any action (only time it executes a defined
-                         // function/subroutine written in the C language).
-                         // All other actions are written in ordinary C,
-                         // not in the special language/coding that the
-                         // virtual machine is written 'in'.
+  vm_run (VM_BATCH); // a batch of instructions per visit from the
+                     // Arduino core, rather than one
 //  delay (300);
 }
 
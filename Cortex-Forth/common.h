@@ -1,4 +1,7 @@
 #define FILE_NAME      "/forth/ascii_xfer_a001.txt"
+#define IMAGE_NAME     "/forth/image.bin"
+#define BOOT_SUM_NAME  "/forth/boot.sum" // hash and size FILE_NAME was written with
+#define SEGMENT_NAME   "/forth/ascii_xfer_a001.seg" // what fload of FILE_NAME compiled
 #define WORKING_DIR "/forth"
 
 #undef VERBIAGE_AA
@@ -9,7 +12,45 @@
 
 #include "SdFat.h"
 extern File thisFile;
-#define WRITE_FORTH(a) {thisFile.print((a));}
-#define WRITELN_FORTH(a) {thisFile.println((a));}
+extern Print *forth_out; // where forth_words () and sam_editor () write
+#define WRITE_FORTH(a) {forth_out->print((a));}
+#define WRITELN_FORTH(a) {forth_out->println((a));}
 
-#define WRITE_VERT_WSPACE(a) {thisFile.println((a));}
+#define WRITE_VERT_WSPACE(a) {forth_out->println((a));}
+
+// src/lexer.cpp - tokens of thisFile, for _FLPARSE
+#define LEX_SECTOR 512     // bytes read from the file at a time
+#define LEX_TOKEN_MAX 128  // longest token; a longer one is cut
+extern int lex_next (const char **tok);
+extern void lex_reset (void);
+
+// src/image.cpp - the compiled dictionary, saved and restored
+#define IMAGE_HASH 2166136261u // FNV-1a offset basis, to start image_hash ()
+extern uint32_t boot_hash; // of FILE_NAME as flash_setup () left it
+extern uint32_t image_hash (const void *p, int n, uint32_t h);
+extern void image_kernel (void);
+extern boolean image_save (void);
+extern boolean image_load (void);
+extern void seg_begin (int base);      // fload: a file about to be compiled
+extern boolean seg_load (int *base);   //   compiled before: put it back
+extern void seg_semi (int cfa);        //   a colon definition ended
+extern void seg_drop (void);           //   not to be kept
+extern void seg_save (int base);       //   read to its end: keep it
+
+// src/profile.cpp - executions and time per word, in a PROFILE build (vm.h)
+#ifdef HOST_BUILD
+#define PROF_BITS 11 // 2048 words
+#else
+#define PROF_BITS 8  // 256 words: 4 kb of SRAM
+#endif // #ifdef HOST_BUILD
+#define PROF_SLOTS (1 << PROF_BITS)
+struct prof_entry {
+  int cfa;        // code field, 0: slot free
+  uint32_t count; // executions
+  uint64_t self;  // time in its own instructions, PROF_UNIT
+};
+extern const char *const prof_unit;
+extern int prof_lost; // executions of words the full table had no room for
+extern void prof_on (void);
+extern void prof_reset (void);
+extern const struct prof_entry *prof_next (const struct prof_entry *e); // next down from e (0: the top), or 0
@@ -1,32 +1,120 @@
 #include <Arduino.h>
 
-extern int T;
-extern void _DROP(void);
-extern void _DUP(void);
+#include "vm.h"
+
 /* from Metro-M4-Express-interpreter/interpret_m4/interpret_m4.ino */
 
+// push n to top of the data stack of machine v
+void vm_push(struct VM *v, int n) {
+  memory.data[--v->S] = v->T;
+  v->T = n;
+  // see the definition of _HERE() for a similar technique to create a new stack element.
+}
+
+// return top of stack of machine v
+int vm_pop(struct VM *v) {
+  int n = v->T;
+  v->T = memory.data[v->S++]; // take care of stack pointer
+  return n;
+}
+
 // push n to top of data stack
 void push(int n) {
-  _DUP();
-  T = n;
-  // see the definition of _HERE() for a similar technique to create a new stack element.
+  vm_push(&vm, n);
 }
 
 // return top of stack
 int pop(void) {
-  int n = T;
-  _DROP(); // take care of stack pointer
-  return n;
+  return vm_pop(&vm);
+}
+
+extern Print *console_out; // Cortex-Forth.ino: the port, output buffered
+
+/* hdump rdump
+
+  16 bytes a row, in hex with ascii on the side, each row put
+  together here and handed to the console in one write:
+
+    00010 : 05 00 00 00 06 00 00 00 07 00 00 00 08 00 00 00   ................
+
+  hdump ( b u - ) takes byte offsets into memory.data, as c@ does;
+  rdump ( a u - ) absolute addresses in SRAM, as rbyte does.  Each
+  is cut to the memory it reads, rather than trapping.
+*/
+
+#define DUMP_ROW 16
+
+static char *dump_hex (char *s, unsigned int n, int digits) {
+  for (int i = digits - 1; i >= 0; i--) s [i] = "0123456789ABCDEF" [(n >> (4 * (digits - 1 - i))) & 15];
+  return s + digits;
+}
+
+// n bytes from p, labelled from a
+static void dump_rows (const unsigned char *p, unsigned int a, int n, int digits) {
+  char row [8 + 3 + (3 * DUMP_ROW) + 2 + DUMP_ROW + 2];
+  while (n > 0) {
+    int k = (n < DUMP_ROW) ? n : DUMP_ROW;
+    char *s = dump_hex (row, a, digits);
+    *s++ = ' '; *s++ = ':'; *s++ = ' ';
+    for (int i = 0; i < DUMP_ROW; i++) {
+      if (i < k) s = dump_hex (s, p [i], 2);
+      else { *s++ = ' '; *s++ = ' '; }
+      *s++ = ' ';
+    }
+    *s++ = ' '; *s++ = ' ';
+    for (int i = 0; i < k; i++) *s++ = ((p [i] < ' ') || (p [i] > '~')) ? '.' : p [i];
+    *s++ = '\r'; *s++ = '\n';
+    console_out->write ((const uint8_t *) row, s - row);
+    p += k; a += k; n -= k;
+  }
+  console_out->flush ();
+}
+
+void _HDUMP (void) { // ( b u - )
+  int u = pop(), b = pop();
+  int size = sizeof (memory.data);
+  if (b < 0) { u += b; b = 0; }
+  if (u > (size - b)) u = size - b;
+  int digits = 1;
+  while ((size - 1) >> (4 * digits)) digits++; // as many as the last offset has
+  if (u > 0) dump_rows ((const unsigned char *) memory.data + b, b, u, digits);
 }
 
-// dump 16 bytes of RAM in hex with ascii on the side
-void _dumpRAM(void) {
+void _RDUMP (void) { // ( a u - )
+  int n = pop();
+  unsigned int a = pop(), u = n;
+  unsigned int top = RBYTE_BASE + RBYTE_SIZE;
+  if (n <= 0) return;
+  if (a < RBYTE_BASE) {
+    if ((RBYTE_BASE - a) >= u) return;
+    u -= RBYTE_BASE - a;
+    a = RBYTE_BASE;
+  }
+  if (a >= top) return;
+  if (u > (top - a)) u = top - a;
+#ifdef HOST_BUILD
+  const unsigned char *p = (const unsigned char *) host_ram (a);
+#else
+  const unsigned char *p = (const unsigned char *) a;
+#endif
+  dump_rows (p, a, u, 8);
 }
 
 void _getOneByteRAM(void) { // ( addr -- )
   char *ram;
   int p = pop(); // address to investigate
+#ifdef MEM_CHECKED
+  if ((unsigned int) (p - RBYTE_BASE) >= RBYTE_SIZE) {
+    mem_trap("rbyte address", p);
+    push(0);
+    return;
+  }
+#endif
+#ifdef HOST_BUILD
+  ram = host_ram(p);
+#else
   ram = (char*)p;
+#endif
   char c = *ram++;
   push((int) c); // can we do this?
 }
@@ -0,0 +1,112 @@
+variable t0
+variable dv
+variable truns
+variable tus
+
+: u/ dv ! 0 swap
+  begin dv @ - dup 0< invert while swap 1 + swap repeat
+  drop ;
+
+: report tus ! truns ! cr 104 99 110 101 98 5 emits .name
+  truns @ . tus @ . tus @ truns @ u/ . cr ;
+
+: run over over micros t0 ! 0 do dup execute loop drop
+  micros t0 @ - report ;
+
+2000 constant ssize
+variable flags ssize allot
+: primes flags ssize 1 fill 0 ssize 0 do
+    flags i + c@ if
+      i dup + 3 + i +
+      begin dup ssize - 0< while
+        0 over flags + c! i dup + 3 + +
+      repeat drop 1 +
+    then
+  loop ;
+: sieve primes drop ;
+
+: fibn dup 2 - 0< if exit then
+  dup 1 - fibn swap 2 - fibn + ;
+: fib 20 fibn drop ;
+
+100 constant bn
+variable ba bn 2* 2* allot
+variable bp
+: cswap bp ! bp @ @ bp @ 4 + @ over over swap - 0<
+  if bp @ ! bp @ 4 + ! exit then drop drop ;
+: binit bn 0 do bn i - i 2* 2* ba + ! loop ;
+: bsort bn 1 - 0 do bn 1 - i - 0 do i 2* 2* ba + cswap loop loop ;
+: bubble binit bsort ;
+
+8 constant mn
+variable mata 252 allot
+variable matb 252 allot
+variable matc 252 allot
+variable mr
+variable mc
+variable mx
+variable my
+: mul my ! mx ! 0
+  begin my @ while
+    my @ 1 and if mx @ + then
+    mx @ 2* mx ! my @ 2/ my !
+  repeat ;
+: mix swap 2* 2* 2* + 2* 2* ;
+: minit mn 0 do mn 0 do
+    j i + j i mix mata + !
+    j i - mn + j i mix matb + !
+  loop loop ;
+: mdot 0 mn 0 do
+    mr @ i mix mata + @ i mc @ mix matb + @ mul +
+  loop ;
+: mmul mn 0 do i mr ! mn 0 do i mc ! mdot mr @ i mix matc + ! loop loop ;
+: matrix minit mmul ;
+
+1024 constant slen
+variable sbuf slen allot
+: sinit slen 0 do i 7 and 97 + sbuf i + c! loop ;
+: ecount 0 sbuf slen + sbuf do i c@ 101 - 0= if 1 + then loop ;
+: scan ecount drop ;
+sinit
+
+: check cr primes . 20 fibn . bubble ba @ . ba 396 + @ .
+  matrix matc 252 + @ . ecount . cr ;
+check
+
+' sieve 20 run
+' fib 20 run
+' bubble 10 run
+' matrix 20 run
+' scan 50 run
+
+: compile ;
+micros t0 !
+: cs-a dup 1 + swap drop ; : cs-b cs-a cs-a ; : cs-c cs-b cs-a ;
+: cs-d cs-c cs-b ; : cs-e 1 2 + drop ; : cs-f cs-e cs-d ;
+: cs-g 0 10 0 do i + loop ; : cs-h cs-g cs-f ; : cs-i cs-h cs-h ;
+: cs-j if cs-a else cs-b then ; : cs-k begin 1 - dup 0< until ;
+: cs-l cs-k cs-j ; : cs-m cs-l cs-k cs-j ; : cs-n 5 cs-m ;
+: cs-o cs-n cs-m cs-l ; : cs-p cs-o cs-n cs-m cs-l cs-k ;
+forget cs-a
+: cs-a dup 1 + swap drop ; : cs-b cs-a cs-a ; : cs-c cs-b cs-a ;
+: cs-d cs-c cs-b ; : cs-e 1 2 + drop ; : cs-f cs-e cs-d ;
+: cs-g 0 10 0 do i + loop ; : cs-h cs-g cs-f ; : cs-i cs-h cs-h ;
+: cs-j if cs-a else cs-b then ; : cs-k begin 1 - dup 0< until ;
+: cs-l cs-k cs-j ; : cs-m cs-l cs-k cs-j ; : cs-n 5 cs-m ;
+: cs-o cs-n cs-m cs-l ; : cs-p cs-o cs-n cs-m cs-l cs-k ;
+forget cs-a
+: cs-a dup 1 + swap drop ; : cs-b cs-a cs-a ; : cs-c cs-b cs-a ;
+: cs-d cs-c cs-b ; : cs-e 1 2 + drop ; : cs-f cs-e cs-d ;
+: cs-g 0 10 0 do i + loop ; : cs-h cs-g cs-f ; : cs-i cs-h cs-h ;
+: cs-j if cs-a else cs-b then ; : cs-k begin 1 - dup 0< until ;
+: cs-l cs-k cs-j ; : cs-m cs-l cs-k cs-j ; : cs-n 5 cs-m ;
+: cs-o cs-n cs-m cs-l ; : cs-p cs-o cs-n cs-m cs-l cs-k ;
+forget cs-a
+: cs-a dup 1 + swap drop ; : cs-b cs-a cs-a ; : cs-c cs-b cs-a ;
+: cs-d cs-c cs-b ; : cs-e 1 2 + drop ; : cs-f cs-e cs-d ;
+: cs-g 0 10 0 do i + loop ; : cs-h cs-g cs-f ; : cs-i cs-h cs-h ;
+: cs-j if cs-a else cs-b then ; : cs-k begin 1 - dup 0< until ;
+: cs-l cs-k cs-j ; : cs-m cs-l cs-k cs-j ; : cs-n 5 cs-m ;
+: cs-o cs-n cs-m cs-l ; : cs-p cs-o cs-n cs-m cs-l cs-k ;
+forget cs-a
+' compile 4 micros t0 @ - report
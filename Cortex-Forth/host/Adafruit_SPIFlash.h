@@ -0,0 +1,24 @@
+// Adafruit_SPIFlash.h  host build stand-in
+
+// There is no flash chip on the host; see SdFat.h for where
+// the files go.
+
+#ifndef HOST_ADAFRUIT_SPIFLASH_H
+#define HOST_ADAFRUIT_SPIFLASH_H
+
+#include "SPI.h"
+
+class Adafruit_FlashTransport { };
+
+class Adafruit_FlashTransport_SPI : public Adafruit_FlashTransport {
+public:
+  Adafruit_FlashTransport_SPI (int ss, SPIClass *spi) { (void) ss; (void) spi; }
+};
+
+class Adafruit_SPIFlash {
+public:
+  Adafruit_SPIFlash (Adafruit_FlashTransport *transport) { (void) transport; }
+  bool begin (void) { return true; }
+};
+
+#endif // #ifndef HOST_ADAFRUIT_SPIFLASH_H
@@ -0,0 +1,147 @@
+// Arduino.h  host build stand-in  (POSIX)
+
+// Only what Cortex-Forth uses of the Arduino core is here:
+// Print, Serial, String, delay, millis, pins and a reset.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define DEC 10
+#define HEX 16
+
+#define LOW    0
+#define HIGH   1
+#define INPUT  0
+#define OUTPUT 1
+
+#define SS 10
+
+class String {
+public:
+  String (void) {}
+  String (const char *s) : s_ (s) {}
+  String (char c) : s_ (1, c) {}
+  String (const std::string &s) : s_ (s) {}
+
+  String & operator = (const char *s) { s_ = s; return *this; }
+  String & operator = (char c) { s_.assign (1, c); return *this; }
+
+  String operator + (char c) const { return String (s_ + c); }
+  String operator + (const char *s) const { return String (s_ + s); }
+  String operator + (const String &s) const { return String (s_ + s.s_); }
+
+  bool operator == (const char *s) const { return s_ == s; }
+
+  // out of range reads and writes land on a dummy, as on Arduino
+  char & operator [] (unsigned int i) {
+    static char dummy;
+    if (i >= s_.length ()) { dummy = 0; return dummy; }
+    return s_ [i];
+  }
+
+  unsigned int length (void) const { return s_.length (); }
+  const char * c_str (void) const { return s_.c_str (); }
+
+private:
+  std::string s_;
+};
+
+class Print {
+public:
+  virtual ~Print (void) {}
+  virtual size_t write (uint8_t c) = 0;
+  virtual size_t write (const uint8_t *buf, size_t n) {
+    for (size_t i = 0; i < n; i++) write (buf [i]);
+    return n;
+  }
+  size_t write (char c) { return write ((uint8_t) c); }
+  size_t write (int c) { return write ((uint8_t) c); }
+  size_t write (const char *s) { return write ((const uint8_t *) s, strlen (s)); }
+  virtual void flush (void) {}
+
+  size_t print (const char *s) { return write (s); }
+  size_t print (char c) { return write (c); }
+  size_t print (const String &s) { return write ((const uint8_t *) s.c_str (), s.length ()); }
+  size_t print (int n, int base = DEC);
+  size_t print (unsigned int n, int base = DEC) { return print ((unsigned long) n, base); }
+  size_t print (long n, int base = DEC);
+  size_t print (unsigned long n, int base = DEC);
+
+  size_t println (void) { return write ("\r\n"); }
+  template <typename V> size_t println (V v) { size_t n = print (v); return n + println (); }
+  template <typename V> size_t println (V v, int base) { size_t n = print (v, base); return n + println (); }
+};
+
+/* Serial
+
+  Reads stdin and writes stdout, or the master side of a pty
+  when the host program is started with -p.  available() looks
+  for input for up to a ms when none is buffered, and returns 0
+  if none came: as on the board, key and parse let the other
+  tasks run meanwhile, and while (!available ()); waits.
+*/
+class HostSerial : public Print {
+public:
+  HostSerial (void);
+  void begin (long baud) { (void) baud; }
+  operator bool (void) { return true; }
+
+  int available (void);
+  int read (void);
+  int peek (void);
+  void flush (void) override;
+
+  using Print::write;
+  size_t write (uint8_t c);
+  size_t write (const uint8_t *buf, size_t n);
+
+  void attach (int in_fd, int out_fd); // host: select the file descriptors
+  void feed (const char *s);           // host: queue input ahead of the fd
+
+private:
+  int fill (void);
+  int in_fd_, out_fd_;
+  char in_ [4096];
+  int in_pos_, in_len_;
+  char out_ [4096];
+  int out_len_;
+};
+
+extern HostSerial Serial;
+extern HostSerial Serial1;
+
+// called when input hits end of file - the default flushes and exits
+extern void (*host_serial_eof) (void);
+
+void delay (unsigned long ms);
+unsigned long millis (void);
+unsigned long micros (void);
+unsigned long host_nanos (void); // monotonic, ns: the profiler's clock
+
+void pinMode (int pin, int mode);
+void digitalWrite (int pin, int val);
+int digitalRead (int pin);
+
+void NVIC_SystemReset (void);
+
+inline bool isDigit (int c) { return isdigit (c) != 0; }
+
+extern int host_no_delay; // nonzero: delay() returns at once (bench)
+extern long host_allocs;   // calls to malloc, calloc and realloc so far
+extern long host_serial_writes; // calls to Serial.write, one char or many: USB transfers on the board
+extern long host_serial_bytes;  // and the bytes they wrote
+
+// the board's SRAM, 192 kb from 0x20000000 (bottom), for rbyte;
+// any other address reads as a zero byte
+char *host_ram (int addr);
+
+#endif // #ifndef HOST_ARDUINO_H
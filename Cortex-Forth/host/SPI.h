@@ -0,0 +1,14 @@
+// SPI.h  host build stand-in
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include "Arduino.h"
+
+#define SPI_INTERFACES_COUNT 1
+
+class SPIClass { };
+
+extern SPIClass SPI;
+
+#endif // #ifndef HOST_SPI_H
@@ -0,0 +1,60 @@
+// SdFat.h  host build stand-in  (POSIX)
+
+// The FAT volume on QSPI flash becomes a directory on the local
+// filesystem: "flash" in the current directory, or the directory
+// named by CORTEX_FORTH_FLASH.  "/forth/ascii_xfer_a001.txt" is
+// then flash/forth/ascii_xfer_a001.txt.
+
+#ifndef HOST_SDFAT_H
+#define HOST_SDFAT_H
+
+#include <stdio.h>
+#include "Arduino.h"
+
+#define FILE_READ  0x01
+#define FILE_WRITE 0x02 // create, append
+
+struct HostFile; // shared by copies of one File, as on SdFat: freed with the last
+
+class File : public Print {
+public:
+  File (void) : f_ (0) {}
+  explicit File (HostFile *f) : f_ (f) {}
+  File (const File &o);
+  File &operator= (const File &o);
+  ~File (void);
+  operator bool (void) const;
+
+  int available (void);
+  int read (void);
+  int read (void *buf, size_t n);
+  int peek (void);
+  bool seek (uint32_t pos);
+  uint32_t position (void);
+  uint32_t size (void);
+  void rewind (void) { seek (0); }
+  void close (void);
+
+  using Print::write;
+  size_t write (uint8_t c);
+  size_t write (const uint8_t *buf, size_t n);
+
+private:
+  HostFile *f_;
+};
+
+class Adafruit_SPIFlash;
+
+class FatFileSystem {
+public:
+  bool begin (Adafruit_SPIFlash *flash);
+  bool exists (const char *path);
+  bool mkdir (const char *path);
+  bool remove (const char *path);
+  File open (const char *path, uint8_t mode = FILE_READ);
+};
+
+extern const char *host_flash_root (void);
+extern long host_flash_written; // bytes written to files, so far
+
+#endif // #ifndef HOST_SDFAT_H
@@ -0,0 +1,786 @@
+// bench.cpp  host build: dispatch-rate benchmark
+
+/*
+
+  ./bench [-n instructions] [-p passes] [-f file] [-s dir]
+
+  flash   flash_setup (), timed: with the boot file to write, and
+          again with it up to date on flash; and bytes written
+  boot    the autoload at the end of setup (), timed
+  fload   the fload path - flparse word find number execute,
+          dictionary addresses 189 - 216 - over and over on
+          the same source file.  The dictionary is put back
+          the way setup () left it, before each pass.
+  loop    instructions per second through the inner interpreter
+          that loop () calls, running the delay word from the
+          boot file:
+              : delay drop 1234 0 do 1 drop loop ;
+          marked checked, profile or trace in a build with those
+          (vm.h; make checked-bench runs the first against none)
+  lex     tokens/s from the file lexer alone, and through fload,
+          for each of the fs/ascii_xfer_a00N_txt.fs sources (-s:
+          where fs/ is; they are copied into the flash directory)
+  image   the boot file compiled by fload, and the same dictionary
+          restored by image_load () from what save-image wrote
+  segment fload (_FLOAD) of the boot file with no segment - compiled,
+          and kept - and again with it put back; whether the two
+          dictionaries are the same, and that another file, and
+          the boot file after it, are compiled, not put back
+  alloc   heap allocations per token parsed, from a file (fload)
+          and from the keyboard (Serial, fed the same file)
+  rx      the keyboard on a pty, written to as fast as the pty
+          takes it by another process: lines that define a word,
+          run it, and forget it, and now and then an s" string;
+          bytes/s, and whether the sum the lines keep came out
+          right (a char lost would spoil it)
+  index   fload tokens/s with the dictionary index and with the
+          linear walk of the links it replaced: for the boot file,
+          and for vocab.fs, a generated vocabulary of 360 words;
+          then spill.fs, more names than the index holds, and
+          whether it compiles the same indexed as walked
+  dump    4 kb dumped by hdump, and by blist a call per 128 bytes
+          as the boot file has it (with its delay per byte)
+  tx      chars/s through blist, the boot file's listing of the
+          dictionary as hex and ascii, with delay cut down to drop;
+          and how many chars went in each write to Serial - on the
+          board, each write is a transfer
+  fuse    instructions dispatched by one blist and one rlist, with
+          the boot file compiled with superinstructions (fused)
+          and without (plain).  delay is cut down to drop, so
+          the count is of the listing words themselves.
+  native  calls of delay, with the boot file compiled threaded and
+          compiled to x86-64 code (native.cpp, as cortex-forth -n)
+  bulk    cmove fill and move on 1 kb and 16 kb, against the same
+          done by a Forth do loop over c@ c! (@ !)
+
+  Output from the Forth goes to /dev/null.  There is no keyboard:
+  a fload run ends when the Forth asks for one.
+
+*/
+
+#include <fcntl.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <string>
+
+#include "Arduino.h"
+#include "SdFat.h"
+#include "../vm.h"
+#include "../common.h"
+
+extern void setup (void);
+extern void flash_setup (void);
+extern void loop (void);
+extern void _WORD (void);
+extern void _FIND (void);
+extern void _DROP (void);
+extern void _FLOAD (void);
+
+extern char tib [];
+extern int tib_len, tib_in, tib_tok;
+extern boolean state;
+extern FatFileSystem fatfs;
+extern boolean dict_indexed;
+extern int dict_spilled;
+
+// addresses in the kernel (kernel.h, by way of vm.h)
+#define PARSE_CFA   K_parse
+#define FLPARSE_CFA K_flparse
+#define FLOAD_QUIT  K_flquit_loop // top of the flparse quit loop
+#define KBD_QUIT    K_quit_loop   // top of the keyboard quit loop
+#define LIT_CFA     K_lit
+#define BRANCH_CFA  K_branch
+#define DO_CFA      K_ddo
+#define LOOP_CFA    K_lloop
+#define EXIT_CFA    K_exit
+#define DROP_CFA    K_drop
+#define FUSE_VAR    508 // fuse, the variable
+#define RAM_BOTTOM  536870912 // board SRAM, where rlist looks
+
+struct bench_stop { };
+
+static void no_keyboard (void) {
+  throw bench_stop ();
+}
+
+static double now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// run the fload quit loop until it hands back to the keyboard
+// quit loop, which asks for input and so ends the run.  With
+// count set, step one instruction at a time, and return the
+// number of tokens flparse delivered.
+static long run_fload (bool count) {
+  long tokens = 0;
+  try {
+    for (;;) {
+      if (!count) {
+        loop ();
+        continue;
+      }
+      if (memory.data [vm.I] == FLPARSE_CFA) tokens++;
+      vm_run (1);
+    }
+  } catch (bench_stop &) {
+  }
+  return tokens - 1; // the last call finds the file closed
+}
+
+static void fload_reset (int kernel_H, int kernel_D, const char *file) {
+  H = kernel_H; D = kernel_D;
+  dict_rehash ();
+  vm.S = S0; vm.R = R0; state = false;
+  thisFile = fatfs.open (file);
+  lex_reset ();
+  if (!thisFile) {
+    fprintf (stderr, "bench: cannot open %s in %s\n", file, host_flash_root ());
+    exit (1);
+  }
+  vm.I = FLOAD_QUIT;
+}
+
+static int find_word (const char *name) {
+  int n = strlen (name);
+  memcpy (tib, name, n);
+  tib [n] = ' ';
+  tib_tok = 0;
+  tib_len = tib_in = (n + 1);
+  _WORD ();
+  _FIND ();
+  int a = vm.T;
+  _DROP ();
+  return a;
+}
+
+// fload file as the word does, from the kernel; true when its
+// segment was put back, and it was not compiled
+static bool seg_fload (int kernel_H, int kernel_D, const char *file) {
+  fload_reset (kernel_H, kernel_D, file);
+  _FLOAD ();
+  bool back = (vm.I == KBD_QUIT);
+  run_fload (false);
+  return back;
+}
+
+// time passes fload runs of file; returns tokens/s
+static double fload_rate (int kernel_H, int kernel_D, const char *file, int passes) {
+  fload_reset (kernel_H, kernel_D, file);
+  long tokens = run_fload (true);
+  double t = now ();
+  for (int p = 0; p < passes; p++) {
+    fload_reset (kernel_H, kernel_D, file);
+    run_fload (false);
+  }
+  t = now () - t;
+  return tokens * passes / t;
+}
+
+// copy src into the flash directory, as /forth/<its name>
+static std::string flash_copy (const char *src) {
+  const char *base = strrchr (src, '/');
+  std::string name = std::string (WORKING_DIR) + "/" + (base ? base + 1 : src);
+  std::string path = std::string (host_flash_root ()) + name;
+  FILE *in = fopen (src, "rb");
+  FILE *out = fopen (path.c_str (), "wb");
+  if (!in || !out) {
+    perror (in ? path.c_str () : src);
+    exit (1);
+  }
+  char buf [4096];
+  size_t n;
+  while ((n = fread (buf, 1, sizeof (buf), in)) > 0) fwrite (buf, 1, n, out);
+  fclose (in);
+  fclose (out);
+  return name;
+}
+
+// lex file passes times, with nothing else; returns tokens/s
+static double lex_rate (const char *file, int passes, long *tokens) {
+  const char *tok;
+  long n = 0;
+  double t = now ();
+  for (int p = 0; p < passes; p++) {
+    thisFile = fatfs.open (file);
+    lex_reset ();
+    while (lex_next (&tok) >= 0) n++;
+    thisFile.close ();
+  }
+  t = now () - t;
+  *tokens = n / passes;
+  return n / t;
+}
+
+// the keyboard: file, fed to Serial a piece at a time as it
+// runs dry, then no_keyboard ()
+static std::string kbd_text;
+static size_t kbd_pos;
+
+static void kbd_feed (void) {
+  if (kbd_pos == kbd_text.size ()) throw bench_stop ();
+  char piece [1025];
+  size_t n = kbd_text.copy (piece, 1024, kbd_pos);
+  piece [n] = 0;
+  kbd_pos += n;
+  Serial.feed (piece);
+}
+
+static void kbd_load (const char *file) {
+  std::string path = std::string (host_flash_root ()) + file;
+  FILE *fp = fopen (path.c_str (), "rb");
+  if (!fp) {
+    perror (path.c_str ());
+    exit (1);
+  }
+  char buf [4096];
+  size_t n;
+  kbd_text.clear ();
+  while ((n = fread (buf, 1, sizeof (buf), fp)) > 0) kbd_text.append (buf, n);
+  fclose (fp);
+  kbd_pos = 0;
+}
+
+// run the keyboard quit loop over what kbd_load () read, a step
+// at a time; returns the number of tokens parse delivered
+static long run_keyboard (int kernel_H, int kernel_D) {
+  H = kernel_H; D = kernel_D;
+  dict_rehash ();
+  vm.S = S0; vm.R = R0; state = false;
+  tib_tok = tib_len = tib_in = 0;
+  vm.I = KBD_QUIT;
+  host_serial_eof = kbd_feed;
+  long tokens = 0;
+  try {
+    for (;;) {
+      if (memory.data [vm.I] == PARSE_CFA) tokens++;
+      vm_run (1);
+    }
+  } catch (bench_stop &) {
+  }
+  host_serial_eof = no_keyboard;
+  return tokens - 1; // the last parse finds no input
+}
+
+// the rx lines: each adds k % 10 + 1 to rxs, through a word it
+// defines and forgets.  Returns what rxs should come to
+static long rx_text (std::string &text, int lines) {
+  char line [128];
+  long sum = 0;
+  text = "variable rxs 0 rxs !\n";
+  for (int k = 0; k < lines; k++) {
+    snprintf (line, sizeof (line), ": rx-%05d rxs @ %d + rxs ! ; rx-%05d forget rx-%05d\n",
+              k, (k % 10) + 1, k, k);
+    text += line;
+    sum += (k % 10) + 1;
+    if (k % 100) continue;
+    text += "s\" ab\" fs@ + + rxs @ + rxs !\n"; // the string ends at the quote, not the line
+    sum += 'a' + 'b' + 2;
+  }
+  return sum;
+}
+
+// type text into the keyboard quit loop through a pty, from a child
+// process; returns the seconds until the pty is closed and read dry
+static double rx_pty (int kernel_H, int kernel_D, const std::string &text) {
+  struct termios tio;
+  int fd = posix_openpt (O_RDWR | O_NOCTTY);
+  if ((fd < 0) || grantpt (fd) || unlockpt (fd)) {
+    perror ("posix_openpt");
+    exit (1);
+  }
+  int slave = open (ptsname (fd), O_RDWR | O_NOCTTY);
+  if ((slave < 0) || tcgetattr (slave, &tio)) {
+    perror (ptsname (fd));
+    exit (1);
+  }
+  cfmakeraw (&tio);
+  tcsetattr (slave, TCSANOW, &tio);
+
+  H = kernel_H; D = kernel_D;
+  dict_rehash ();
+  vm.S = S0; vm.R = R0; state = false;
+  rx_reset ();
+  vm.I = KBD_QUIT;
+  Serial.attach (fd, open ("/dev/null", O_WRONLY));
+
+  double t = now ();
+  pid_t pid = fork ();
+  if (pid == 0) {
+    size_t done = 0;
+    while (done < text.size ()) {
+      ssize_t n = write (slave, text.data () + done, text.size () - done);
+      if (n <= 0) _exit (1);
+      done += n;
+    }
+    tcdrain (slave);
+    _exit (0);
+  }
+  close (slave);
+  try {
+    for (;;) loop ();
+  } catch (bench_stop &) {
+  }
+  t = now () - t;
+  waitpid (pid, 0, 0);
+  Serial.attach (-1, open ("/dev/null", O_WRONLY));
+  close (fd);
+  return t;
+}
+
+// an application vocabulary: n words, each calling the two before it
+#define VOCAB_FILE "/forth/vocab.fs"
+#define SPILL_FILE "/forth/spill.fs"
+
+static void write_vocab (int n) {
+  std::string path = std::string (host_flash_root ()) + VOCAB_FILE;
+  FILE *fp = fopen (path.c_str (), "w");
+  if (!fp) {
+    perror (path.c_str ());
+    exit (1);
+  }
+  for (int k = 0; k < n; k++) {
+    fprintf (fp, ": vocab-%03d dup 1 + swap drop", k);
+    for (int j = k - 2; j < k; j++)
+      if (j >= 0) fprintf (fp, " vocab-%03d", j);
+    fprintf (fp, " ;\r\n");
+  }
+  fclose (fp);
+}
+
+// n empty words, more than the index holds, and one that calls
+// every tenth of them: the latest ones are looked for down the links
+static void write_spill (int n) {
+  std::string path = std::string (host_flash_root ()) + SPILL_FILE;
+  FILE *fp = fopen (path.c_str (), "w");
+  if (!fp) {
+    perror (path.c_str ());
+    exit (1);
+  }
+  for (int k = 0; k < n; k++) fprintf (fp, ": sp%d ;\r\n", k);
+  fprintf (fp, ": spills");
+  for (int k = 0; k < n; k += 10) fprintf (fp, " sp%d", k);
+  fprintf (fp, " ;\r\n");
+  fclose (fp);
+}
+
+// compile the boot file again, fused or plain, and count the
+// instructions one call of name takes
+static long count_listing (int kernel_H, int kernel_D, const char *file,
+                           int fused, const char *name, int addr) {
+  fload_reset (kernel_H, kernel_D, file);
+  memory.data [FUSE_VAR] = fused;
+  run_fload (false);
+  int delay_word = find_word ("delay");
+  int word = find_word (name);
+  if (!delay_word || !word) {
+    fprintf (stderr, "bench: no delay or %s word in %s\n", name, file);
+    exit (1);
+  }
+  memory.data [delay_word + 3] = DROP_CFA;
+  memory.data [delay_word + 4] = EXIT_CFA;
+
+  int stub = H; // lit addr name
+  memory.data [stub + 0] = LIT_CFA;
+  memory.data [stub + 1] = addr;
+  memory.data [stub + 2] = word + 2;
+  vm.S = S0; vm.R = R0; vm.I = stub;
+  long n = 0;
+  while (vm.I != stub + 3) n += vm_run (1);
+  return n;
+}
+
+// lit a lit u word, run to the branch to itself after it
+static void run_word (int word, int a, int u) {
+  int stub = H;
+  memory.data [stub + 0] = LIT_CFA;
+  memory.data [stub + 1] = a;
+  memory.data [stub + 2] = LIT_CFA;
+  memory.data [stub + 3] = u;
+  memory.data [stub + 4] = word + 2;
+  memory.data [stub + 5] = BRANCH_CFA;
+  memory.data [stub + 6] = stub + 5;
+  vm.S = S0; vm.R = R0; vm.I = stub;
+  do vm_run (VM_BATCH); while ((vm.I != stub + 5) && (vm.I != stub + 6));
+}
+
+// chars/s from blist 0, run reps times; *per: chars per Serial write.
+// delay is left cut down to drop
+static double tx_rate (int reps, double *per) {
+  int delay_word = find_word ("delay");
+  int word = find_word ("blist");
+  if (!delay_word || !word) {
+    fprintf (stderr, "bench: no delay or blist word\n");
+    exit (1);
+  }
+  memory.data [delay_word + 3] = DROP_CFA;
+  memory.data [delay_word + 4] = EXIT_CFA;
+  long writes = host_serial_writes, bytes = host_serial_bytes;
+  double t = now ();
+  for (int k = 0; k < reps; k++) run_word (word, 0, 0); // blist ignores the 0 above its address
+  t = now () - t;
+  bytes = host_serial_bytes - bytes;
+  *per = (double) bytes / (host_serial_writes - writes);
+  return bytes / t;
+}
+
+// seconds to dump size bytes from 0 with hdump, and with blist -
+// 128 bytes a call, as the boot file has it, delay and all
+static double dump_time (const char *name, int size) {
+  int word = find_word (name);
+  if (!word) {
+    fprintf (stderr, "bench: no %s word\n", name);
+    exit (1);
+  }
+  double t = now ();
+  if (!strcmp (name, "hdump")) run_word (word, 0, size);
+  else for (int a = 0; a < size; a += 128) run_word (word, 0, a);
+  return now () - t;
+}
+
+// the bulk memory words, and the Forth loops they stand in for
+#define BULK_FILE "/forth/bulk.fs"
+#define BULK_SRC  32768 // bytes: two 16 kb buffers, well above the boot dictionary
+#define BULK_DST  49152
+
+static void write_bulk (void) {
+  std::string path = std::string (host_flash_root ()) + BULK_FILE;
+  FILE *fp = fopen (path.c_str (), "w");
+  if (!fp) {
+    perror (path.c_str ());
+    exit (1);
+  }
+  fprintf (fp, ": lcmove 0 do over i + c@ over i + c! loop drop drop ;\r\n");
+  fprintf (fp, ": lfill swap 0 do over i + over swap c! loop drop drop ;\r\n");
+  fprintf (fp, ": lmove 0 do over i + @ over i + ! 4 +loop drop drop ;\r\n");
+  fprintf (fp, ": ldrop drop drop drop ;\r\n");
+  fclose (fp);
+}
+
+// seconds per call of word on size bytes: reps calls from a do
+// loop, less the same loop calling ldrop
+static double bulk_loop (int word, int a, int b, int c, int reps) {
+  int stub = H; // lit reps lit 0 do lit a lit b lit c word loop stub+5 branch stub+14
+  int code [] = { LIT_CFA, reps, LIT_CFA, 0, DO_CFA, LIT_CFA, a, LIT_CFA, b,
+                  LIT_CFA, c, word, LOOP_CFA, stub + 5, BRANCH_CFA, stub + 14 };
+  for (int k = 0; k < (int) (sizeof (code) / sizeof (code [0])); k++) memory.data [stub + k] = code [k];
+  vm.S = S0; vm.R = R0; vm.I = stub;
+  double t = now ();
+  while (vm.I < stub + 14) vm_run (VM_BATCH);
+  return now () - t;
+}
+
+struct bulk_word {
+  const char *name, *loop; // the word, and its Forth loop
+  char args;               // b: ( a1 a2 u)  f: ( a u c)
+};
+
+static double bulk_time (const char *name, char args, int size, int reps) {
+  int word = find_word (name), none = find_word ("ldrop");
+  if (!word || !none) {
+    fprintf (stderr, "bench: no %s or ldrop word in %s\n", name, BULK_FILE);
+    exit (1);
+  }
+  int a = BULK_SRC, b = BULK_DST, c = size;
+  if (args == 'f') {
+    b = size; c = 'x';
+  }
+  double t = bulk_loop (word + 2, a, b, c, reps) - bulk_loop (none + 2, a, b, c, reps);
+  return t / reps;
+}
+
+#ifdef HOST_NATIVE
+extern int host_native;
+
+// compile the boot file, threaded or native as host_native says,
+// and time passes * 1000 calls of delay
+static double delay_rate (int kernel_H, int kernel_D, const char *file, int passes) {
+  fload_reset (kernel_H, kernel_D, file);
+  run_fload (false);
+  int delay_word = find_word ("delay");
+  if (!delay_word) {
+    fprintf (stderr, "bench: no delay word in %s\n", file);
+    exit (1);
+  }
+  int stub = H; // lit n lit 0 do lit 0 delay loop stub+5 branch stub+10
+  int code [] = { LIT_CFA, passes * 1000, LIT_CFA, 0, DO_CFA, LIT_CFA, 0,
+                  delay_word + 2, LOOP_CFA, stub + 5, BRANCH_CFA, stub + 10 };
+  for (int k = 0; k < (int) (sizeof (code) / sizeof (code [0])); k++) memory.data [stub + k] = code [k];
+  vm.S = S0; vm.R = R0; vm.I = stub;
+  double t = now ();
+  while (vm.I < stub + 10) vm_run (VM_BATCH);
+  return now () - t;
+}
+#endif // #ifdef HOST_NATIVE
+
+int main (int argc, char **argv) {
+  long instructions = 100000000;
+  int passes = 50;
+  const char *file = FILE_NAME;
+  const char *fs_dir = "../fs";
+  int opt;
+
+  while ((opt = getopt (argc, argv, "n:p:f:s:")) != -1) {
+    switch (opt) {
+    case 'n': instructions = atol (optarg); break;
+    case 'p': passes = atoi (optarg); break;
+    case 'f': file = optarg; break;
+    case 's': fs_dir = optarg; break;
+    default:
+      fprintf (stderr, "usage: %s [-n instructions] [-p passes] [-f file] [-s dir]\n", argv [0]);
+      return 2;
+    }
+  }
+
+  host_no_delay = 1;
+  host_serial_eof = no_keyboard;
+  Serial.attach (-1, open ("/dev/null", O_WRONLY));
+
+  try {
+    std::string image = std::string (host_flash_root ()) + IMAGE_NAME;
+    std::string segment = std::string (host_flash_root ()) + SEGMENT_NAME;
+    remove (image.c_str ()); // the boot compiles the boot file
+    remove (segment.c_str ());
+    setup (); // writes FILE_NAME, leaves vm.I at the autoload
+    int kernel_H = H, kernel_D = D;
+
+    for (int k = 0; k < 2; k++) {
+      std::string sum = std::string (host_flash_root ()) + BOOT_SUM_NAME;
+      if (k == 0) remove (sum.c_str ()); // as after a firmware update
+      long written = host_flash_written;
+      double t = now ();
+      for (int p = 0; p < passes; p++) {
+        if (k == 0) remove (sum.c_str ());
+        thisFile.close ();
+        flash_setup ();
+      }
+      t = (now () - t) / passes;
+      written = (host_flash_written - written) / passes;
+      printf ("flash  %-9s %6ld bytes written        %9.6f s\n", k ? "unchanged" : "written", written, t);
+    }
+
+    double t = now ();
+    run_fload (false);
+    t = now () - t;
+
+    fload_reset (kernel_H, kernel_D, file);
+    long tokens = run_fload (true);
+    printf ("boot   %10ld tokens            %9.6f s  %12.0f tokens/s\n", tokens, t, tokens / t);
+
+    t = now ();
+    for (int p = 0; p < passes; p++) {
+      fload_reset (kernel_H, kernel_D, file);
+      run_fload (false);
+    }
+    t = now () - t;
+    printf ("fload  %10ld tokens x %4d    %9.6f s  %12.0f tokens/s\n", tokens, passes, t, tokens * passes / t);
+    double compiled = t / passes;
+
+    for (int k = 1; k <= 4; k++) {
+      char src [256];
+      long lexed;
+      snprintf (src, sizeof (src), "%s/ascii_xfer_a00%d_txt.fs", fs_dir, k);
+      std::string name = flash_copy (src);
+      double lex = lex_rate (name.c_str (), passes * 10, &lexed);
+      double fl = fload_rate (kernel_H, kernel_D, name.c_str (), passes);
+      printf ("lex    %-26s  %6ld tokens %10.0f lexed %10.0f fload tokens/s\n",
+              name.c_str (), lexed, lex, fl);
+    }
+
+    {
+      fload_reset (kernel_H, kernel_D, file);
+      run_fload (false);
+      if (!image_save ()) {
+        fprintf (stderr, "bench: cannot save %s\n", IMAGE_NAME);
+        return 1;
+      }
+      int boot_H = H;
+      t = now ();
+      for (int p = 0; p < passes; p++) {
+        H = kernel_H; D = kernel_D;
+        if (!image_load ()) {
+          fprintf (stderr, "bench: cannot load %s\n", IMAGE_NAME);
+          return 1;
+        }
+      }
+      t = (now () - t) / passes;
+      remove (image.c_str ());
+      printf ("image  H %5d                   %9.6f s restored %9.6f s compiled  x%.1f\n",
+              boot_H, t, compiled, compiled / t);
+    }
+
+    {
+      remove (segment.c_str ());
+      t = now ();
+      bool back = seg_fload (kernel_H, kernel_D, file);
+      double kept = now () - t;
+      int seg_H = H, seg_D = D;
+      uint32_t sum = image_hash (memory.data, H * sizeof (int), IMAGE_HASH);
+      int hits = 0;
+      t = now ();
+      for (int p = 0; p < passes; p++) hits += seg_fload (kernel_H, kernel_D, file);
+      t = (now () - t) / passes;
+      bool same = !back && (hits == passes) && (H == seg_H) && (D == seg_D) &&
+                  (image_hash (memory.data, H * sizeof (int), IMAGE_HASH) == sum);
+      printf ("segment H %5d  %9.6f s kept  %9.6f s put back %9.6f s compiled  x%.1f  %s\n",
+              seg_H, kept, t, compiled, compiled / t, same ? "same" : "DIFFERENT");
+      char src [256];
+      snprintf (src, sizeof (src), "%s/ascii_xfer_a002_txt.fs", fs_dir);
+      std::string other = flash_copy (src);
+      bool compiled_both = !seg_fload (kernel_H, kernel_D, other.c_str ()) &&
+                           !seg_fload (kernel_H, kernel_D, file);
+      printf ("segment %s, then %s: %s\n", other.c_str (), file,
+              compiled_both ? "compiled both" : "WRONG - put back");
+      remove (segment.c_str ());
+    }
+
+    {
+      fload_reset (kernel_H, kernel_D, file);
+      thisFile.peek (); // the file's stdio buffer: allocated once, on first read
+      long before = host_allocs;
+      long fl = run_fload (true);
+      long fl_allocs = host_allocs - before;
+      kbd_load (file);
+      before = host_allocs;
+      long kb = run_keyboard (kernel_H, kernel_D);
+      long kb_allocs = host_allocs - before;
+      fl_allocs -= 1; kb_allocs -= 1; // the bench_stop each run ends with
+      printf ("alloc  fload    %6ld tokens %6ld allocations  %.3f per token\n",
+              fl, fl_allocs, (double) fl_allocs / fl);
+      printf ("alloc  keyboard %6ld tokens %6ld allocations  %.3f per token\n",
+              kb, kb_allocs, (double) kb_allocs / kb);
+    }
+
+    {
+      std::string text;
+      long sum = rx_text (text, passes * 1000);
+      t = rx_pty (kernel_H, kernel_D, text);
+      int rxs = find_word ("rxs");
+      long got = rxs ? memory.data [rxs + 3] : -1;
+      printf ("rx     pty  %8zu bytes %6d lines %9.6f s  %12.0f bytes/s  sum %s\n",
+              text.size (), passes * 1000, t, text.size () / t, (got == sum) ? "right" : "WRONG");
+    }
+
+    write_vocab (360);
+    const char *sources [] = { file, VOCAB_FILE };
+    for (int k = 0; k < 2; k++) {
+      dict_indexed = true;
+      double hashed = fload_rate (kernel_H, kernel_D, sources [k], passes);
+      dict_indexed = false;
+      double walked = fload_rate (kernel_H, kernel_D, sources [k], passes);
+      dict_indexed = true;
+      printf ("index  %-26s  %10.0f indexed %10.0f walked tokens/s  x%.2f\n",
+              sources [k], hashed, walked, hashed / walked);
+    }
+    {
+      int n = (DICT_SLOTS * 3) / 4 + 100;
+      write_spill (n);
+      fload_reset (kernel_H, kernel_D, SPILL_FILE);
+      run_fload (false);
+      int spilled = dict_spilled, idx_H = H;
+      uint32_t sum = image_hash (memory.data, H * sizeof (int), IMAGE_HASH);
+      dict_indexed = false;
+      fload_reset (kernel_H, kernel_D, SPILL_FILE);
+      run_fload (false);
+      bool same = (H == idx_H) && (image_hash (memory.data, H * sizeof (int), IMAGE_HASH) == sum);
+      dict_indexed = true;
+      double hashed = fload_rate (kernel_H, kernel_D, SPILL_FILE, passes);
+      dict_indexed = false;
+      double walked = fload_rate (kernel_H, kernel_D, SPILL_FILE, passes);
+      dict_indexed = true;
+      printf ("index  %-26s  %10.0f indexed %10.0f walked tokens/s  x%.2f  %d spilled, %s\n",
+              SPILL_FILE, hashed, walked, hashed / walked, spilled, same ? "same" : "DIFFERENT");
+    }
+    fload_reset (kernel_H, kernel_D, file);
+    run_fload (false);
+
+    int delay_word = find_word ("delay");
+    if (!delay_word) {
+      fprintf (stderr, "bench: no delay word in %s\n", file);
+      return 1;
+    }
+    int stub = H; // lit 0 delay branch stub
+    memory.data [stub + 0] = LIT_CFA;
+    memory.data [stub + 1] = 0;
+    memory.data [stub + 2] = delay_word + 2;
+    memory.data [stub + 3] = BRANCH_CFA;
+    memory.data [stub + 4] = stub;
+    vm.S = S0; vm.R = R0; vm.I = stub;
+
+    t = now ();
+    for (long n = instructions; n > 0; n -= VM_BATCH) vm_run (VM_BATCH);
+    t = now () - t;
+    std::string build;
+#ifdef MEM_CHECKED
+    build += " checked";
+#endif
+#ifdef PROFILE
+    build += " profile";
+#endif
+#ifdef TRACE
+    build += " trace";
+#endif
+    printf ("loop   %10ld instructions    %9.6f s  %12.0f instructions/s %s\n", instructions, t, instructions / t, build.c_str ());
+
+    {
+      double native = dump_time ("hdump", 4096);
+      double forth = dump_time ("blist", 4096);
+      printf ("dump   4096 bytes   %9.6f s hdump %9.6f s blist           x%.0f\n",
+              native, forth, forth / native);
+    }
+
+    {
+      double per;
+      double rate = tx_rate (passes * 200, &per);
+      printf ("tx     blist %6d runs                  %12.0f chars/s %8.1f chars per write\n",
+              passes * 200, rate, per);
+    }
+
+    const char *names [] = { "blist", "rlist" };
+    int addrs [] = { 0, RAM_BOTTOM };
+    for (int k = 0; k < 2; k++) {
+      long fused = count_listing (kernel_H, kernel_D, file, -1, names [k], addrs [k]);
+      long plain = count_listing (kernel_H, kernel_D, file, 0, names [k], addrs [k]);
+      printf ("fuse   %s %8ld fused %8ld plain               %5.1f%% fewer dispatches\n",
+              names [k], fused, plain, 100.0 * (plain - fused) / plain);
+    }
+    memory.data [FUSE_VAR] = -1;
+
+#ifdef HOST_NATIVE
+    {
+      double threaded = delay_rate (kernel_H, kernel_D, file, passes);
+      host_native = 1;
+      double native = delay_rate (kernel_H, kernel_D, file, passes);
+      host_native = 0;
+      fload_reset (kernel_H, kernel_D, file);
+      run_fload (false);
+      printf ("native delay %6d calls          %9.6f s threaded %9.6f s native  x%.1f\n",
+              passes * 1000, threaded, native, threaded / native);
+    }
+#endif // #ifdef HOST_NATIVE
+
+    write_bulk ();
+    fload_reset (kernel_H, kernel_D, BULK_FILE);
+    run_fload (false);
+    struct bulk_word bulk [] = { { "cmove", "lcmove", 'b' }, { "fill", "lfill", 'f' }, { "move", "lmove", 'b' } };
+    for (int k = 0; k < 3; k++) {
+      for (int size = 1024; size <= 16384; size *= 16) {
+        int reps = passes * 160 * 1024 / size;
+        double native = bulk_time (bulk [k].name, bulk [k].args, size, reps);
+        double forth = bulk_time (bulk [k].loop, bulk [k].args, size, reps);
+        printf ("bulk   %-6s %5d bytes %12.3f us native %12.3f us Forth loop  x%.0f\n",
+                bulk [k].name, size, native * 1e6, forth * 1e6, forth / native);
+      }
+    }
+  } catch (bench_stop &) {
+    fprintf (stderr, "bench: the Forth asked for keyboard input (I = %d)\n", vm.I);
+    return 1;
+  }
+  return 0;
+}
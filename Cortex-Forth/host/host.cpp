@@ -0,0 +1,370 @@
+// host.cpp  POSIX stand-ins for the Arduino core, SdFat and the NVIC
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+
+#include "Arduino.h"
+#include "SdFat.h"
+#include "SPI.h"
+
+// - - - -   heap allocation counter   - - - -
+
+// glibc: ours are called in place of its own, for every malloc in
+// the program - operator new and std::string included
+
+extern "C" void *__libc_malloc (size_t n);
+extern "C" void *__libc_calloc (size_t n, size_t size);
+extern "C" void *__libc_realloc (void *p, size_t n);
+
+long host_allocs = 0;
+
+extern "C" void *malloc (size_t n) {
+  host_allocs++;
+  return __libc_malloc (n);
+}
+
+extern "C" void *calloc (size_t n, size_t size) {
+  host_allocs++;
+  return __libc_calloc (n, size);
+}
+
+extern "C" void *realloc (void *p, size_t n) {
+  host_allocs++;
+  return __libc_realloc (p, n);
+}
+
+// - - - -   Print   - - - -
+
+static size_t print_unsigned (Print *p, unsigned long n, int base) {
+  char buf [8 * sizeof (long) + 1];
+  char *s = &buf [sizeof (buf) - 1];
+  *s = 0;
+  if (base < 2) base = 10;
+  do {
+    int d = n % base;
+    *--s = (d < 10) ? ('0' + d) : ('A' + d - 10);
+    n /= base;
+  } while (n);
+  return p->write (s);
+}
+
+size_t Print::print (long n, int base) {
+  if (base != 10) return print_unsigned (this, (uint32_t) n, base); // 32-bit, as on the Cortex-M
+  if (n < 0) return write ('-') + print_unsigned (this, -n, 10);
+  return print_unsigned (this, n, 10);
+}
+
+size_t Print::print (int n, int base) {
+  return print ((long) n, base);
+}
+
+size_t Print::print (unsigned long n, int base) {
+  return print_unsigned (this, n, base);
+}
+
+// - - - -   Serial   - - - -
+
+static void default_eof (void) {
+  Serial.flush ();
+  exit (0);
+}
+
+void (*host_serial_eof) (void) = default_eof;
+
+HostSerial Serial;
+HostSerial Serial1;
+
+HostSerial::HostSerial (void)
+  : in_fd_ (0), out_fd_ (1), in_pos_ (0), in_len_ (0), out_len_ (0) {
+}
+
+void HostSerial::attach (int in_fd, int out_fd) {
+  flush ();
+  in_fd_ = in_fd;
+  out_fd_ = out_fd;
+}
+
+void HostSerial::feed (const char *s) {
+  int n = strlen (s);
+  if (in_pos_ == in_len_) in_pos_ = in_len_ = 0;
+  if (n > (int) sizeof (in_) - in_len_) {
+    memmove (in_, in_ + in_pos_, in_len_ - in_pos_);
+    in_len_ -= in_pos_;
+    in_pos_ = 0;
+  }
+  if (n > (int) sizeof (in_) - in_len_) n = sizeof (in_) - in_len_;
+  memcpy (in_ + in_len_, s, n);
+  in_len_ += n;
+}
+
+// look for input, for up to a ms; returns bytes buffered
+int HostSerial::fill (void) {
+  if (in_pos_ < in_len_) return in_len_ - in_pos_;
+  flush (); // the prompt goes out before we wait on the reply
+  in_pos_ = in_len_ = 0;
+  for (;;) {
+    int n = 0;
+    if (in_fd_ >= 0) {
+      struct pollfd p = { in_fd_, POLLIN, 0 };
+      int r = poll (&p, 1, 1);
+      if (r == 0) return 0; // none yet - a while (!available ()); comes round again
+      if ((r < 0) && (errno == EINTR)) continue;
+      n = ::read (in_fd_, in_, sizeof (in_));
+    }
+    if (n > 0) { in_len_ = n; return n; }
+    if ((n < 0) && (errno == EINTR)) continue;
+    host_serial_eof (); // may not return
+    return 0;
+  }
+}
+
+int HostSerial::available (void) {
+  return fill ();
+}
+
+int HostSerial::read (void) {
+  if (in_pos_ == in_len_) return -1;
+  return (unsigned char) in_ [in_pos_++];
+}
+
+int HostSerial::peek (void) {
+  if (in_pos_ == in_len_) return -1;
+  return (unsigned char) in_ [in_pos_];
+}
+
+long host_serial_writes = 0;
+long host_serial_bytes = 0;
+
+size_t HostSerial::write (uint8_t c) {
+  host_serial_writes++;
+  host_serial_bytes++;
+  out_ [out_len_++] = c;
+  if (out_len_ == (int) sizeof (out_)) flush ();
+  return 1;
+}
+
+size_t HostSerial::write (const uint8_t *buf, size_t n) {
+  host_serial_writes++;
+  host_serial_bytes += n;
+  for (size_t done = 0; done < n; ) {
+    size_t k = n - done;
+    if (k > sizeof (out_) - out_len_) k = sizeof (out_) - out_len_;
+    memcpy (out_ + out_len_, buf + done, k);
+    out_len_ += k;
+    done += k;
+    if (out_len_ == (int) sizeof (out_)) flush ();
+  }
+  return n;
+}
+
+void HostSerial::flush (void) {
+  int done = 0;
+  while (done < out_len_) {
+    int n = ::write (out_fd_, out_ + done, out_len_ - done);
+    if (n <= 0) {
+      if ((n < 0) && (errno == EINTR)) continue;
+      break; // reader went away - drop it, as USB CDC does
+    }
+    done += n;
+  }
+  out_len_ = 0;
+}
+
+// - - - -   time, pins, reset   - - - -
+
+int host_no_delay = 0;
+
+void delay (unsigned long ms) {
+  if (host_no_delay) return;
+  Serial.flush ();
+  usleep (ms * 1000);
+}
+
+static uint64_t host_usec (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t host_epoch = host_usec ();
+
+unsigned long millis (void) {
+  return (host_usec () - host_epoch) / 1000;
+}
+
+unsigned long micros (void) {
+  return host_usec () - host_epoch;
+}
+
+unsigned long host_nanos (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (unsigned long) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void pinMode (int pin, int mode) { (void) pin; (void) mode; }
+void digitalWrite (int pin, int val) { (void) pin; (void) val; }
+int digitalRead (int pin) { (void) pin; return LOW; }
+
+#define HOST_RAM_BASE 0x20000000
+#define HOST_RAM_SIZE (192 * 1024)
+
+char *host_ram (int addr) {
+  static char ram [HOST_RAM_SIZE];
+  static char none;
+  unsigned int a = (unsigned int) addr - HOST_RAM_BASE;
+  if (a >= HOST_RAM_SIZE) {
+    none = 0;
+    return &none;
+  }
+  return &ram [a];
+}
+
+char **host_argv; // set by main () for the reset below
+
+void NVIC_SystemReset (void) {
+  Serial.flush ();
+  if (host_argv) execv ("/proc/self/exe", host_argv);
+  exit (1);
+}
+
+SPIClass SPI;
+
+// - - - -   File and FatFileSystem   - - - -
+
+struct HostFile {
+  FILE *fp;
+  long size; // kept here, so available () is a subtraction
+  int refs;  // Files that hold it
+};
+
+static std::string host_path (const char *path) {
+  std::string p = host_flash_root ();
+  if (path [0] != '/') p += '/';
+  return p + path;
+}
+
+const char *host_flash_root (void) {
+  const char *root = getenv ("CORTEX_FORTH_FLASH");
+  return root ? root : "flash";
+}
+
+// a File lets go of f: the last one closes the file
+static void host_file_drop (HostFile *f) {
+  if (!f || --f->refs) return;
+  if (f->fp) fclose (f->fp);
+  delete f;
+}
+
+File::File (const File &o) : Print (o), f_ (o.f_) {
+  if (f_) f_->refs++;
+}
+
+File &File::operator= (const File &o) {
+  HostFile *was = f_;
+  f_ = o.f_;
+  if (f_) f_->refs++;
+  host_file_drop (was);
+  return *this;
+}
+
+File::~File (void) {
+  host_file_drop (f_);
+}
+
+File::operator bool (void) const {
+  return f_ && f_->fp;
+}
+
+uint32_t File::size (void) {
+  if (!*this) return 0;
+  return f_->size;
+}
+
+uint32_t File::position (void) {
+  if (!*this) return 0;
+  return ftell (f_->fp);
+}
+
+int File::available (void) {
+  if (!*this) return 0;
+  return size () - position ();
+}
+
+int File::read (void) {
+  if (!*this) return -1;
+  int c = fgetc (f_->fp);
+  return (c == EOF) ? -1 : c;
+}
+
+int File::read (void *buf, size_t n) {
+  if (!*this) return -1;
+  return fread (buf, 1, n, f_->fp);
+}
+
+int File::peek (void) {
+  int c = read ();
+  if (c >= 0) ungetc (c, f_->fp);
+  return c;
+}
+
+bool File::seek (uint32_t pos) {
+  if (!*this) return false;
+  return fseek (f_->fp, pos, SEEK_SET) == 0;
+}
+
+void File::close (void) {
+  if (!*this) return;
+  fclose (f_->fp);
+  f_->fp = 0;
+}
+
+size_t File::write (uint8_t c) {
+  return write (&c, 1);
+}
+
+long host_flash_written = 0;
+
+size_t File::write (const uint8_t *buf, size_t n) {
+  if (!*this) return 0;
+  n = fwrite (buf, 1, n, f_->fp);
+  host_flash_written += n;
+  long pos = ftell (f_->fp);
+  if (pos > f_->size) f_->size = pos;
+  return n;
+}
+
+bool FatFileSystem::begin (Adafruit_SPIFlash *flash) {
+  (void) flash;
+  ::mkdir (host_flash_root (), 0755);
+  return true;
+}
+
+bool FatFileSystem::exists (const char *path) {
+  struct stat st;
+  return stat (host_path (path).c_str (), &st) == 0;
+}
+
+bool FatFileSystem::mkdir (const char *path) {
+  return ::mkdir (host_path (path).c_str (), 0755) == 0;
+}
+
+bool FatFileSystem::remove (const char *path) {
+  return ::remove (host_path (path).c_str ()) == 0;
+}
+
+File FatFileSystem::open (const char *path, uint8_t mode) {
+  FILE *fp = fopen (host_path (path).c_str (), (mode == FILE_WRITE) ? "a+" : "r");
+  if (!fp) return File ();
+  struct stat st;
+  HostFile *f = new HostFile;
+  f->fp = fp;
+  f->refs = 1;
+  f->size = fstat (fileno (fp), &st) ? 0 : st.st_size;
+  return File (f);
+}
@@ -0,0 +1,93 @@
+// main.cpp  host build: run the sketch on a terminal or a pty
+
+/*
+
+  ./cortex-forth          Serial is stdin/stdout
+  ./cortex-forth -p       Serial is a new pty; its name is printed
+                          on stderr - connect as to the board:
+                              microcom -p /dev/pts/N
+  ./cortex-forth -n       colon definitions compiled to x86-64
+                          code (native.cpp) - x86-64 builds only
+
+  Files go in ./flash, or wherever CORTEX_FORTH_FLASH points.
+
+*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+
+extern void setup (void);
+extern void loop (void);
+
+extern char **host_argv;
+#ifdef HOST_NATIVE
+extern int host_native;
+#endif // #ifdef HOST_NATIVE
+
+static struct termios saved_tio;
+
+static void restore_tty (void) {
+  Serial.flush ();
+  tcsetattr (0, TCSANOW, &saved_tio);
+}
+
+// the board sees each keystroke and echoes it; do the same here
+static void raw_tty (void) {
+  struct termios tio;
+  if (!isatty (0) || tcgetattr (0, &saved_tio)) return;
+  tio = saved_tio;
+  tio.c_lflag &= ~(ICANON | ECHO);
+  tio.c_cc [VMIN] = 1;
+  tio.c_cc [VTIME] = 0;
+  tcsetattr (0, TCSANOW, &tio);
+  atexit (restore_tty);
+}
+
+static int open_pty (void) {
+  struct termios tio;
+  int fd = posix_openpt (O_RDWR | O_NOCTTY);
+  if ((fd < 0) || grantpt (fd) || unlockpt (fd)) {
+    perror ("posix_openpt");
+    exit (1);
+  }
+  // hold the slave open, so the master reads block rather than
+  // fail while no terminal program is connected
+  int slave = open (ptsname (fd), O_RDWR | O_NOCTTY);
+  if ((slave >= 0) && !tcgetattr (slave, &tio)) {
+    cfmakeraw (&tio);
+    tcsetattr (slave, TCSANOW, &tio);
+  }
+  fprintf (stderr, "Serial is on %s\n", ptsname (fd));
+  return fd;
+}
+
+int main (int argc, char **argv) {
+  int opt, pty = 0;
+  host_argv = argv;
+  while ((opt = getopt (argc, argv, "pn")) != -1) {
+    switch (opt) {
+    case 'p': {
+      int fd = open_pty ();
+      Serial.attach (fd, fd);
+      pty = 1;
+      break;
+    }
+#ifdef HOST_NATIVE
+    case 'n':
+      host_native = 1;
+      break;
+#endif // #ifdef HOST_NATIVE
+    default:
+      fprintf (stderr, "usage: %s [-p] [-n]\n", argv [0]);
+      return 2;
+    }
+  }
+  if (!pty) raw_tty ();
+  setup ();
+  for (;;) loop ();
+}
@@ -0,0 +1,522 @@
+// native.cpp  host build: colon definitions compiled to x86-64 code
+
+/*
+  See native.h.  The code keeps the machine in registers:
+
+    rbx   memory.data
+    r12d  S, data stack pointer (a cell number, as in vm)
+    r13d  T, top of stack
+    r14d  R, return stack pointer
+    r15   &vm
+
+  A native word is entered by a call, with these live, and returns
+  with them live.  The caller writes the return address _NEST
+  would push, and the prologue moves R down over it, so the return
+  stack reads the same either way.  Primitives with no code here are called in C,
+  with the registers written to vm around the call.  A colon word
+  with native code is called directly; one without goes through
+  threaded (), which runs its body in the inner interpreter.
+
+  native_call () is the way in from C: it loads the registers from
+  vm, calls the word, and stores them back.
+*/
+
+#ifdef HOST_NATIVE
+
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "Arduino.h"
+#include "../vm.h"
+#include "native.h"
+
+#define NATIVE_BUF (4 << 20) // bytes of code, for all the native words
+#define NATIVE_FIXUPS 4096   // forward branches in one word
+
+int host_native = 0;
+int native_depth = 0;
+void *native_entry [RAM_SIZE];
+int native_owner [RAM_SIZE];
+
+static unsigned char *buf, *top, *buf_end;
+static unsigned char *enter_code;    // void enter (void *word)
+static unsigned char *threaded_code; // edi: code field; runs it threaded
+
+struct native_word {
+  int cfa;
+  unsigned char *code;
+};
+
+static struct native_word words [RAM_SIZE / 4]; // in the order compiled
+static int nwords = 0;
+
+// - - - -   x86-64 encoding   - - - -
+
+enum { RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+       R12 = 12, R13 = 13, R14 = 14, R15 = 15 };
+
+#define CC_E  0x4 // je
+#define CC_NE 0x5 // jne
+#define CC_AE 0x3 // jae, unsigned
+#define CC_NS 0x9 // jns
+
+static void e1 (int b) {
+  if (top < buf_end) *top = (unsigned char) b;
+  top++;
+}
+
+static void e4 (int v) {
+  for (int i = 0; i < 4; i++) e1 (v >> (8 * i));
+}
+
+static void e8 (uint64_t v) {
+  for (int i = 0; i < 8; i++) e1 ((int) (v >> (8 * i)));
+}
+
+static void rex (int w, int reg, int index, int base) {
+  int r = 0x40 | (w << 3) | ((reg & 8) >> 1) | ((index & 8) >> 2) | ((base & 8) >> 3);
+  if (r != 0x40) e1 (r);
+}
+
+// op reg, [base + index << scale + disp] - index -1 for none; op
+// 0x0fxx for the two byte ones
+static void mem (int w, int op, int reg, int base, int index, int scale, int disp) {
+  rex (w, reg, (index < 0) ? 0 : index, base);
+  if (op > 0xff) e1 (op >> 8);
+  e1 (op & 0xff);
+  int mod = ((disp == 0) && ((base & 7) != RBP)) ? 0 : ((disp >= -128) && (disp <= 127)) ? 1 : 2;
+  if ((index < 0) && ((base & 7) != RSP)) {
+    e1 ((mod << 6) | ((reg & 7) << 3) | (base & 7));
+  } else {
+    e1 ((mod << 6) | ((reg & 7) << 3) | RSP);
+    e1 ((scale << 6) | ((((index < 0) ? RSP : index) & 7) << 3) | (base & 7));
+  }
+  if (mod == 1) e1 (disp);
+  if (mod == 2) e4 (disp);
+}
+
+// op reg, rm - both registers; reg is the /digit for the unary ops
+static void rr (int w, int op, int reg, int rm) {
+  rex (w, reg, 0, rm);
+  e1 (op);
+  e1 (0xc0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+static void mov_imm (int r, int v) {
+  rex (0, 0, 0, r);
+  e1 (0xb8 + (r & 7));
+  e4 (v);
+}
+
+static void mov_imm64 (int r, const void *p) {
+  rex (1, 0, 0, r);
+  e1 (0xb8 + (r & 7));
+  e8 ((uint64_t) p);
+}
+
+static void rel32 (unsigned char *to) { // after the opcode
+  e4 ((int) (to - (top + 4)));
+}
+
+static unsigned char *jcc (int cc) { // returns where the rel32 goes
+  e1 (0x0f);
+  e1 (0x80 | cc);
+  e4 (0);
+  return top - 4;
+}
+
+static unsigned char *jmp (void) {
+  e1 (0xe9);
+  e4 (0);
+  return top - 4;
+}
+
+static void patch (unsigned char *at, unsigned char *to) {
+  int v = (int) (to - (at + 4));
+  memcpy (at, &v, 4);
+}
+
+// the machine, in registers
+
+#define DS(d) RBX, R12, 2, (4 * (d)) // memory.data [S + d]
+#define RS(d) RBX, R14, 2, (4 * (d)) // memory.data [R + d]
+#define AT(r) RBX, (r), 2, 0          // memory.data [r]
+#define BYTE_AT(r) RBX, (r), 0, 0     // MEM_BYTES [r]
+
+static void dup_ (void) {  // memory.data [--S] = T
+  rr (0, 0xff, 1, R12);
+  mem (0, 0x89, R13, DS (0));
+}
+
+static void drop_ (void) { // T = memory.data [S++]
+  mem (0, 0x8b, R13, DS (0));
+  rr (0, 0xff, 0, R12);
+}
+
+static void spill (void) {
+  mem (0, 0x89, R12, R15, -1, 0, offsetof (struct VM, S));
+  mem (0, 0x89, R13, R15, -1, 0, offsetof (struct VM, T));
+  mem (0, 0x89, R14, R15, -1, 0, offsetof (struct VM, R));
+}
+
+static void reload (void) {
+  mem (0, 0x8b, R12, R15, -1, 0, offsetof (struct VM, S));
+  mem (0, 0x8b, R13, R15, -1, 0, offsetof (struct VM, T));
+  mem (0, 0x8b, R14, R15, -1, 0, offsetof (struct VM, R));
+}
+
+static void call_c (const void *fn) {
+  mov_imm64 (RAX, fn);
+  rr (0, 0xff, 2, RAX); // call rax
+}
+
+// rax = T, sign extended: a byte address
+static void t_to_rax (void) {
+  rr (1, 0x63, RAX, R13); // movsxd rax, r13d
+}
+
+// rax = CELL_OF (rax)
+static void cell_rax (void) {
+  rr (1, 0xc1, 7, RAX);   // sar rax, 2
+  e1 (2);
+}
+
+// after a store to memory.data [rax]: is it in a native body?
+static void stored_rax (void) {
+  rr (0, 0x81, 7, RAX);                  // cmp eax, RAM_SIZE
+  e4 (RAM_SIZE);
+  unsigned char *out = jcc (CC_AE);
+  mov_imm64 (RDX, native_owner);
+  mem (0, 0x83, 7, RDX, RAX, 2, 0);      // cmp dword [rdx + rax * 4], 0
+  e1 (0);
+  unsigned char *none = jcc (CC_E);
+  spill ();
+  rr (0, 0x89, RAX, RDI);                // mov edi, eax
+  call_c ((const void *) native_store);
+  reload ();
+  patch (out, top);
+  patch (none, top);
+}
+
+// - - - -   from C   - - - -
+
+// a colon word, run threaded from native code: as _NEST, the
+// caller having written the return address, until exit pops it
+static void threaded (int cfa) {
+  int I = vm.I, R = vm.R--;
+  vm.I = cfa + 1;
+  while (vm.R < R) vm_run (1);
+  vm.I = I;
+}
+
+static void native_init (void) {
+  void *p = mmap (0, NATIVE_BUF, PROT_READ | PROT_WRITE | PROT_EXEC,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    host_native = 0;
+    return;
+  }
+  buf = top = (unsigned char *) p;
+  buf_end = buf + NATIVE_BUF;
+
+  enter_code = top;
+  e1 (0x53);                  // push rbx
+  e1 (0x41); e1 (0x54);       // push r12
+  e1 (0x41); e1 (0x55);       // push r13
+  e1 (0x41); e1 (0x56);       // push r14
+  e1 (0x41); e1 (0x57);       // push r15
+  mov_imm64 (R15, &vm);
+  mov_imm64 (RBX, memory.data);
+  reload ();
+  rr (0, 0xff, 2, RDI);       // call rdi
+  spill ();
+  e1 (0x41); e1 (0x5f);       // pop r15
+  e1 (0x41); e1 (0x5e);       // pop r14
+  e1 (0x41); e1 (0x5d);       // pop r13
+  e1 (0x41); e1 (0x5c);       // pop r12
+  e1 (0x5b);                  // pop rbx
+  e1 (0xc3);                  // ret
+
+  threaded_code = top;
+  e1 (0x48); e1 (0x83); e1 (0xec); e1 (0x08); // sub rsp, 8
+  spill ();
+  call_c ((const void *) threaded);           // edi: the code field
+  reload ();
+  e1 (0x48); e1 (0x83); e1 (0xc4); e1 (0x08); // add rsp, 8
+  e1 (0xc3);
+}
+
+void native_call (int cfa) { // vm.I: what _NEST would push
+  memory.data [vm.R - 1] = vm.I;
+  native_depth++;
+  ((void (*) (void *)) enter_code) (native_entry [cfa]);
+  native_depth--;
+}
+
+// back to threaded code: its entry becomes mov edi, cfa; jmp threaded
+static void unmake (int cfa) {
+  unsigned char *code = (unsigned char *) native_entry [cfa];
+  native_entry [cfa] = 0;
+  for (int a = cfa; (a < RAM_SIZE) && (native_owner [a] == cfa); a++) native_owner [a] = 0;
+  if (!code) return;
+  unsigned char *keep = top;
+  top = code;
+  mov_imm (RDI, cfa);
+  e1 (0xe9);
+  rel32 (threaded_code);
+  top = keep;
+}
+
+void native_store (int a) {
+  if (native_owner [a]) unmake (native_owner [a]);
+}
+
+void native_forget (int h) {
+  while (nwords && (words [nwords - 1].cfa >= h)) {
+    nwords--;
+    native_entry [words [nwords].cfa] = 0;
+    top = words [nwords].code;
+  }
+  for (int a = (h < 0) ? 0 : h; a < RAM_SIZE; a++) native_owner [a] = 0;
+}
+
+// - - - -   the compiler   - - - -
+
+// the operand cell that follows some instructions
+static int has_operand (int p) {
+  switch (p) {
+  case P_LIT: case P_BRANCH: case P_0BRANCH: case P_LOOP:
+  case P_LITPLUS: case P_LITMINUS: case P_LITAND: case P_PLOOP: case P_LEAVE:
+    return 1;
+  }
+  return 0;
+}
+
+static int code_at [RAM_SIZE]; // offset from entry of the code for a body cell, or -1
+
+struct fixup {
+  unsigned char *at; // rel32
+  int target;        // body cell
+};
+
+static struct fixup fixups [NATIVE_FIXUPS];
+
+// can the instruction x be compiled?
+static int known (int x) {
+  if ((x < 0) || (x >= RAM_SIZE)) return 0;
+  int p = memory.data [x];
+  if ((p <= P_NONE) || (p >= PRIM_COUNT)) return 0;
+  switch (p) {
+  case P_EXECUTE: case P_TICK: case P_FLOAD: case P_FLPARSE: case P_THROWN:
+  case P_FORGET: case P_KEY: case P_PARSE: case P_PAUSE: case P_STOP:
+  case P_ACTIVATE: case P_INITR: case P_INITS:
+    return 0;
+  }
+  return 1;
+}
+
+void native_compile (int cfa) {
+  if (!host_native) return;
+#ifdef MEM_CHECKED
+  return; // the code here does not check what it loads and stores
+#endif
+#if defined(PROFILE) || defined(TRACE)
+  return; // nor count or trace what it runs
+#endif
+  if (!buf) native_init ();
+  if (!buf || (memory.data [cfa] != P_NEST)) return;
+  int start = cfa + 1, stop = H;
+  if ((stop <= start) || (stop > RAM_SIZE)) return;
+
+  for (int a = start; a < stop; a++) code_at [a] = -1;
+  for (int a = start; a < stop; ) { // every instruction known, operands inside
+    int x = memory.data [a];
+    if (!known (x)) return;
+    code_at [a] = 0;
+    a += 1 + has_operand (memory.data [x]);
+    if (a > stop) return;
+  }
+  for (int a = start; a < stop; ) { // branches land on instructions
+    int p = memory.data [memory.data [a]];
+    if ((p == P_BRANCH) || (p == P_0BRANCH) || (p == P_LOOP) ||
+        (p == P_PLOOP) || (p == P_LEAVE)) {
+      int to = memory.data [a + 1];
+      if ((to < start) || (to >= stop) || (code_at [to] < 0)) return;
+    }
+    a += 1 + has_operand (p);
+  }
+
+  unsigned char *entry = top;
+  int nfix = 0;
+  e1 (0x0f); e1 (0x1f); e1 (0x44); e1 (0); e1 (0); // nop: room for unmake ()
+  e1 (0x0f); e1 (0x1f); e1 (0x44); e1 (0); e1 (0);
+  e1 (0x48); e1 (0x83); e1 (0xec); e1 (0x08);      // sub rsp, 8
+  rr (0, 0xff, 1, R14);                            // R-- as _NEST
+
+  unsigned char *exits [NATIVE_FIXUPS];
+  int nexit = 0;
+
+  for (int a = start; a < stop; ) {
+    int x = memory.data [a];
+    int p = memory.data [x];
+    int n = has_operand (p) ? memory.data [a + 1] : 0;
+    code_at [a] = (int) (top - entry);
+    if ((nfix >= NATIVE_FIXUPS - 2) || (nexit >= NATIVE_FIXUPS - 1)) {
+      top = entry;
+      return;
+    }
+    switch (p) {
+    case P_NOP: break;
+    case P_LIT: dup_ (); mov_imm (R13, n); break;
+    case P_BRANCH:
+      fixups [nfix].at = jmp ();
+      fixups [nfix++].target = n;
+      break;
+    case P_0BRANCH:
+      rr (0, 0x89, R13, RAX); drop_ ();            // eax = T
+      rr (0, 0x85, RAX, RAX);                      // test eax, eax
+      fixups [nfix].at = jcc (CC_E);
+      fixups [nfix++].target = n;
+      break;
+    case P_DO:
+      rr (0, 0x89, R13, RAX); mem (0, 0x2b, RAX, DS (0)); // index - limit
+      rr (0, 0xff, 1, R14); mem (0, 0x89, RAX, RS (0)); drop_ ();
+      rr (0, 0xff, 1, R14); mem (0, 0x89, R13, RS (0)); drop_ ();
+      break;
+    case P_LOOP:
+      mem (0, 0xff, 0, RS (1));                    // inc offset
+      fixups [nfix].at = jcc (CC_NE);
+      fixups [nfix++].target = n;
+      rr (0, 0x81, 0, R14); e4 (2);                // R += 2
+      break;
+    case P_PLOOP:
+      mem (0, 0x8b, RAX, RS (1));                  // eax = offset
+      rr (0, 0x89, R13, RCX); drop_ ();            // ecx = n
+      rr (0, 0x89, RAX, RDX); rr (0, 0x01, RCX, RDX);
+      mem (0, 0x89, RDX, RS (1));                  // offset + n
+      rr (0, 0x31, RAX, RDX);                      // same sign: on
+      fixups [nfix].at = jcc (CC_NS);
+      fixups [nfix++].target = n;
+      rr (0, 0x31, RAX, RCX);                      // n toward -1: on
+      fixups [nfix].at = jcc (CC_NS);
+      fixups [nfix++].target = n;
+      rr (0, 0x81, 0, R14); e4 (2);
+      break;
+    case P_LEAVE:
+      rr (0, 0x81, 0, R14); e4 (2);
+      fixups [nfix].at = jmp ();
+      fixups [nfix++].target = n;
+      break;
+    case P_UNLOOP: rr (0, 0x81, 0, R14); e4 (2); break;
+    case P_I: dup_ (); mem (0, 0x8b, R13, RS (1)); mem (0, 0x03, R13, RS (0)); break;
+    case P_J: dup_ (); mem (0, 0x8b, R13, RS (3)); mem (0, 0x03, R13, RS (2)); break;
+    case P_R: dup_ (); rr (0, 0x89, R14, R13); rr (0, 0xc1, 4, R13); e1 (2); break;
+    case P_EXIT: exits [nexit++] = jmp (); break;
+    case P_NEST:
+      mem (0, 0xc7, 0, RS (-1)); e4 (a + 1);       // what _NEST would push
+      if (x == cfa) {
+        e1 (0xe8); rel32 (entry);
+      } else if (native_entry [x]) {
+        e1 (0xe8); rel32 ((unsigned char *) native_entry [x]);
+      } else {
+        mov_imm (RDI, x);
+        e1 (0xe8); rel32 (threaded_code);
+      }
+      break;
+    case P_DOVAR: dup_ (); mov_imm (R13, (x + 1) * 4); break;
+    case P_DOCONST: dup_ (); mem (0, 0x8b, R13, RBX, -1, 0, 4 * (x + 1)); break;
+    case P_DUP: dup_ (); break;
+    case P_DROP: drop_ (); break;
+    case P_QDUP: {
+      rr (0, 0x85, R13, R13);
+      unsigned char *zero = jcc (CC_E);
+      dup_ ();
+      patch (zero, top);
+      break;
+    }
+    case P_SWAP:
+      mem (0, 0x8b, RAX, DS (0)); mem (0, 0x89, R13, DS (0)); rr (0, 0x89, RAX, R13);
+      break;
+    case P_OVER: dup_ (); mem (0, 0x8b, R13, DS (1)); break;
+    case P_FETCH: t_to_rax (); cell_rax (); mem (0, 0x8b, R13, AT (RAX)); break;
+    case P_STORE:
+      t_to_rax (); cell_rax (); mem (0, 0x8b, RCX, DS (0)); mem (0, 0x89, RCX, AT (RAX));
+      mem (0, 0x8b, R13, DS (1)); rr (0, 0x81, 0, R12); e4 (2);
+      stored_rax ();
+      break;
+    case P_CFETCH: t_to_rax (); mem (0, 0x0fb6, R13, BYTE_AT (RAX)); break; // movzx
+    case P_CSTORE:
+      t_to_rax (); mem (0, 0x8b, RCX, DS (0)); mem (0, 0x88, RCX, BYTE_AT (RAX));
+      mem (0, 0x8b, R13, DS (1)); rr (0, 0x81, 0, R12); e4 (2);
+      cell_rax ();
+      stored_rax ();
+      break;
+    case P_PLUS:  mem (0, 0x03, R13, DS (0)); rr (0, 0xff, 0, R12); break;
+    case P_aND:   mem (0, 0x23, R13, DS (0)); rr (0, 0xff, 0, R12); break;
+    case P_OR:    mem (0, 0x0b, R13, DS (0)); rr (0, 0xff, 0, R12); break;
+    case P_XOR:   mem (0, 0x33, R13, DS (0)); rr (0, 0xff, 0, R12); break;
+    case P_MINUS:
+      mem (0, 0x8b, RAX, DS (0)); rr (0, 0x29, R13, RAX); rr (0, 0x89, RAX, R13);
+      rr (0, 0xff, 0, R12);
+      break;
+    case P_INVERT:   rr (0, 0xf7, 2, R13); break;
+    case P_NEGATE:   rr (0, 0xf7, 3, R13); break;
+    case P_ABS:
+      rr (0, 0x89, R13, RAX); rr (0, 0xc1, 7, RAX); e1 (31); // eax = T >> 31
+      rr (0, 0x31, RAX, R13); rr (0, 0x29, RAX, R13);       // T = (T ^ eax) - eax
+      break;
+    case P_TWOSTAR:  rr (0, 0xd1, 4, R13); break;
+    case P_TWOSLASH: rr (0, 0xd1, 7, R13); break;
+    case P_ZEROLESS: rr (0, 0xc1, 7, R13); e1 (31); break;
+    case P_DEPTH:
+      mov_imm64 (RAX, &task_s0); mem (0, 0x8b, RAX, RAX, -1, 0, 0); // the task's S0
+      rr (0, 0x29, R12, RAX); dup_ (); rr (0, 0x89, RAX, R13);
+      break;
+    case P_OVEROVER:
+      dup_ (); mem (0, 0x8b, R13, DS (1)); dup_ (); mem (0, 0x8b, R13, DS (1));
+      break;
+    case P_OVEROVERMINUS:
+      dup_ (); mem (0, 0x8b, RAX, DS (1)); rr (0, 0x29, R13, RAX); rr (0, 0x89, RAX, R13);
+      break;
+    case P_OVEROVERSWAP: dup_ (); dup_ (); mem (0, 0x8b, R13, DS (2)); break;
+    case P_OVEROVERSWAPMINUS: dup_ (); mem (0, 0x2b, R13, DS (1)); break;
+    case P_DUPFETCH: dup_ (); t_to_rax (); cell_rax (); mem (0, 0x8b, R13, AT (RAX)); break;
+    case P_SWAPDROP: rr (0, 0xff, 0, R12); break;
+    case P_LITPLUS:  rr (0, 0x81, 0, R13); e4 (n); break;
+    case P_LITMINUS: rr (0, 0x81, 5, R13); e4 (n); break;
+    case P_LITAND:   rr (0, 0x81, 4, R13); e4 (n); break;
+    case P_MINUSZEROLESS:
+      rr (0, 0x89, R13, RAX); drop_ (); rr (0, 0x29, RAX, R13);
+      rr (0, 0xc1, 7, R13); e1 (31);
+      break;
+    default: // in C, on vm
+      spill ();
+      mem (0, 0xc7, 0, R15, -1, 0, offsetof (struct VM, W)); e4 (x);
+      call_c ((const void *) CELL_FN (p));
+      reload ();
+      break;
+    }
+    a += 1 + has_operand (p);
+  }
+
+  unsigned char *epilogue = top;
+  rr (0, 0xff, 0, R14);                            // R++
+  e1 (0x48); e1 (0x83); e1 (0xc4); e1 (0x08);      // add rsp, 8
+  e1 (0xc3);                                       // ret
+
+  if (top > buf_end) { // out of room: stays threaded
+    top = entry;
+    return;
+  }
+  for (int k = 0; k < nfix; k++) patch (fixups [k].at, entry + code_at [fixups [k].target]);
+  for (int k = 0; k < nexit; k++) patch (exits [k], epilogue);
+
+  native_entry [cfa] = entry;
+  for (int a = cfa; a < stop; a++) native_owner [a] = cfa;
+  words [nwords].cfa = cfa;
+  words [nwords].code = entry;
+  nwords++;
+}
+
+#endif // #ifdef HOST_NATIVE
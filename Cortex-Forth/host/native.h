@@ -0,0 +1,53 @@
+// native.h  host build: colon definitions compiled to x86-64 code
+
+/*
+  With host_native set (./cortex-forth -n), _SEMI hands each new
+  colon definition to native_compile ().  When every instruction
+  in it is one the compiler knows, the word gets x86-64 code, and
+  native_entry [] points at it: the inner interpreter runs that in
+  place of nesting into the body.  The body stays as it was, so
+  memory.data reads the same either way, and ' and execute still
+  run it threaded.
+
+  A word that runs execute, ', fload or flparse is left threaded.
+  So is a word whose body is written to after it is compiled: a
+  store into a native body (NATIVE_STORED) puts it back, and any
+  native word that calls it then calls the threaded code.
+
+  No task switch happens while a native word runs (NATIVE_NESTED):
+  the machine is in the x86's registers and stack.  pause does
+  nothing there, and key and parse wait where they are.  Words
+  that pause are themselves left threaded.
+
+  A MEM_CHECKED, PROFILE or TRACE build (vm.h) compiles nothing:
+  everything runs threaded, where it is checked, counted and traced.
+*/
+
+#ifndef HOST_NATIVE_H
+#define HOST_NATIVE_H
+
+#include "../vm.h"
+
+extern int host_native;                 // nonzero: compile to native code
+extern void *native_entry [RAM_SIZE];   // code for the code field at a, or 0
+extern int native_owner [RAM_SIZE];     // code field of the native body holding a, or 0
+
+extern void native_compile (int cfa);   // at _SEMI: the word just finished
+extern void native_call (int cfa);      // run it, on vm
+extern void native_store (int a);       // cell a, in a native body, was written
+extern void native_forget (int h);      // words from h up are gone
+extern int native_depth;                // native_call ()s under way
+
+#define NATIVE_NESTED (native_depth)
+
+// cell a was written: check for a native body there
+#define NATIVE_STORED(a) { \
+  if (((unsigned int) (a) < RAM_SIZE) && native_owner [a]) native_store (a); \
+}
+
+// cells a up to z were written
+#define NATIVE_STORED_CELLS(a, z) { \
+  for (int a_ = (a); a_ < (z); a_++) NATIVE_STORED (a_); \
+}
+
+#endif // #ifndef HOST_NATIVE_H
@@ -0,0 +1,463 @@
+// kernel.h  the kernel dictionary, a cell at a time
+
+/*
+  The kernel's words and bodies, in the order they sit in memory.
+  No line gives an address: the compiler counts the cells.
+
+    CODE(t, p)          primitive p, and a code field for it
+    WORD(t, f, s, p)    primitive p, and a word named s for it, with
+                        flags f (IMMED): name cell, link, code field
+    PRIM(p)             primitive p, with no cell here: for code
+                        fields made as the dictionary grows
+    CODE_OF(t, p)       a code field for p, a primitive given above
+    WORD_OF(t, f, s, p) a word named s for p, a primitive given above
+    LABEL(t)            K_t is the address of the cell below
+    DATA(v)             one cell: an instruction (a K_ address), an
+                        operand, a value
+
+  K_t is the address of the code field of CODE and WORD lines: what
+  a body holds to run it.  Each word is linked to the one named
+  before it.  Primitives are numbered in the order CODE, WORD and
+  PRIM give them; add new ones at the end, and a number keeps its
+  meaning.
+
+  vm.h reads it for the numbers of the primitives and for the
+  addresses (K_); Cortex-Forth.ino for prim_table [], the names and
+  their links, and the cells, kernel_image [].  The last word named
+  is D at boot, and the cell after the last, KERNEL_H, is H.
+
+  One DATA to a line: each is counted under the number of its line.
+  No include guard: it is meant to be read more than once, and it
+  undefines the seven at its end.
+*/
+
+
+  // run-time code fields
+  PRIM(_NEST)
+  PRIM(_DOVAR)
+  PRIM(_DOCONST)
+
+  // unlinked primitives
+  CODE(lit, _LIT)
+  CODE(branch, _BRANCH)
+  CODE(zbranch, _0BRANCH)
+  CODE(ddo, _DO)
+  CODE(lloop, _LOOP)
+  CODE(initr, _INITR)
+  CODE(inits, _INITS)
+  CODE(showtib, _SHOWTIB)
+  CODE(ok, _OK)
+  // superinstructions - see _COMPILE
+  CODE(overover, _OVEROVER)
+  CODE(overoverminus, _OVEROVERMINUS)
+  CODE(overoverswap, _OVEROVERSWAP)
+  CODE(overoverswapminus, _OVEROVERSWAPMINUS)
+  CODE(dupfetch, _DUPFETCH)
+  CODE(swapdrop, _SWAPDROP)
+  CODE(litplus, _LITPLUS)
+  CODE(litminus, _LITMINUS)
+  CODE(litand, _LITAND)
+  CODE(minuszeroless, _MINUSZEROLESS)
+
+  // trailing space kludge
+  WORD(nop, 0, "", _NOP)
+  // exit
+  WORD(exit, 0, "exit", _EXIT)
+  // key ( - c)
+  WORD(key, 0, "key", _KEY)
+  // emit ( c - )
+  WORD(emit, 0, "emit", _EMIT)
+  // cr
+  WORD(cr, 0, "cr", _CR)
+  // parse // leaves string in tib
+  WORD(parse, 0, "parse", _PARSE)
+  // word ( - n) gets string from tib
+  WORD(wword, 0, "word", _WORD)
+  // dup ( n - n n)
+  WORD(dup, 0, "dup", _DUP)
+  // drop ( n - )
+  WORD(drop, 0, "drop", _DROP)
+  // swap ( n1 n2 - n2 n1)
+  WORD(swap, 0, "swap", _SWAP)
+  // over ( n1 n2 - n1 n2 n1)
+  WORD(over, 0, "over", _OVER)
+  // @ ( a - n) a: byte address, of a cell
+  WORD(fetch, 0, "@", _FETCH)
+  // ! ( n a - )
+  WORD(store, 0, "!", _STORE)
+  // , ( n - )
+  WORD(comma, 0, ",", _COMMA)
+  // find ( n - a)
+  WORD(find, 0, "find", _FIND)
+  // execute ( a)
+  WORD(execute, 0, "execute", _EXECUTE)
+  // ?dup ( n - 0 | n n)
+  WORD(qdup, 0, "?dup", _QDUP)
+  // number ( - n -f) gets string from tib
+  WORD(number, 0, "number", _NUMBER)
+  // depth ( - n)
+  WORD(depth, 0, "depth", _DEPTH)
+  // 0< ( n - f)
+  WORD(zeroless, 0, "0<", _ZEROLESS)
+
+  // abort: empty stacks, and on into quit's loop.  Its header, and
+  // those of flabort, bye, sfabort and aloha below, were never
+  // linked in; only the bodies are kept
+  LABEL(abort)
+  DATA(K_inits)
+  // again
+  DATA(K_branch)
+  DATA(K_quit_restart)
+  // quit
+  WORD_OF(quit, 0, "quit", _NEST)
+  LABEL(quit_restart)
+  DATA(K_initr)
+  // begin quit loop
+  LABEL(quit_loop)
+  DATA(K_parse)
+  DATA(K_wword)
+  DATA(K_find)
+  DATA(K_qdup)
+  DATA(K_zbranch)
+  DATA(K_quit_number) // to number
+  DATA(K_execute)
+  DATA(K_depth)
+  DATA(K_zeroless)
+  DATA(K_zbranch)
+  DATA(K_quit_ok) // to ok
+  DATA(K_branch)
+  DATA(K_quit_what)
+  LABEL(quit_number)
+  DATA(K_number)
+  DATA(K_zbranch)
+  DATA(K_quit_ok) // to ok
+  LABEL(quit_what)
+  DATA(K_nop) // tnr, suppressed with a nop // DATA(K_showtib)
+  DATA(K_lit)
+  DATA('?')
+  DATA(K_emit)
+  DATA(K_cr)
+  DATA(K_inits)
+  DATA(K_branch) // most operands for control structures have the branch dest after 'branch' or 'lloop'.
+  DATA(K_quit_restart)
+  LABEL(quit_ok)
+  DATA(K_ok)
+  DATA(K_branch)
+  DATA(K_quit_loop) // continue quit loop
+
+  // flparse // leaves string in tib
+  WORD(flparse, 0, "flparse", _FLPARSE)
+
+  // sfparse // leaves string in tib
+  WORD(sfparse, 0, "sfparse", _SFPARSE)
+
+  // flabort
+  LABEL(flabort)
+  DATA(K_inits)
+  // fload loop - again
+  DATA(K_branch)
+  DATA(K_flquit_restart)
+  LABEL(flquit_restart)
+  DATA(K_initr)
+  // begin quit loop
+  LABEL(flquit_loop)
+  DATA(K_flparse) // latest change
+  DATA(K_wword) // gets string from tib
+  DATA(K_find)
+  DATA(K_qdup)
+  DATA(K_zbranch)
+  DATA(K_flquit_number) // to number
+  DATA(K_execute)
+  DATA(K_depth)
+  DATA(K_zeroless)
+  DATA(K_zbranch)
+  DATA(K_flquit_ok) // to ok
+  DATA(K_branch)
+  DATA(K_flquit_what)
+  LABEL(flquit_number)
+  DATA(K_number)
+  DATA(K_zbranch)
+  DATA(K_flquit_ok) // to ok
+  LABEL(flquit_what)
+  DATA(K_tracehold) // below - was a nop (tnr)
+  DATA(K_lit)
+  DATA('~') // was '?' in the original
+  DATA(K_emit)
+  DATA(K_cr)
+  DATA(K_inits)
+  DATA(K_branch)
+  DATA(K_flquit_restart)
+  LABEL(flquit_ok)
+  DATA(K_ok)
+  DATA(K_branch)
+  DATA(K_flquit_loop) // continue quit loop
+
+  // sfabort
+  LABEL(sfabort)
+  DATA(K_inits)
+  // sfload loop - again
+  DATA(K_branch)
+  DATA(K_sfquit_restart)
+  LABEL(sfquit_restart)
+  DATA(K_initr)
+  // begin local sfparse quit loop
+  // sfparse does nothing, now . . .  02 SEP 2019
+  LABEL(sfquit_loop)
+  DATA(K_sfparse)
+  DATA(K_branch)
+  DATA(K_sfquit_loop) // continue the local quit loop
+
+  // . ( n - )
+  WORD(dot, 0, ".", _DOT)
+  // .s
+  WORD(ddots, 0, ".s", _DDOTS)
+  // words
+  WORD(words, 0, "words", _WORDS)
+  // space
+  WORD(space, 0, "space", _SPACE)
+  // h. ( n - )
+  WORD(hdot, 0, "h.", _HDOT)
+  // + ( n1 n2 - n3)
+  WORD(plus, 0, "+", _PLUS)
+  // - ( n1 n2 - n3)
+  WORD(minus, 0, "-", _MINUS)
+  // and (n1 n2 - n3)
+  WORD(aand, 0, "and", _aND)
+  // or ( n1 n2 - n3)
+  WORD(oor, 0, "or", _OR)
+  // xor ( n1 n2 - n3)
+  WORD(xxor, 0, "xor", _XOR)
+  // invert ( n1 - n2)
+  WORD(invert, 0, "invert", _INVERT)
+  // abs ( n1 - n2)
+  WORD(abs, 0, "abs", _ABS)
+  // negate ( n1 - n2)
+  WORD(negate, 0, "negate", _NEGATE)
+  // 2* ( n1 - n2)
+  WORD(twostar, 0, "2*", _TWOSTAR)
+  // 2/ ( n1 - n2)
+  WORD(twoslash, 0, "2/", _TWOSLASH)
+  // dump ( a n - a+4n) n cells from a
+  WORD(dump, 0, "dump", _DUMP)
+  // create
+  WORD(create, 0, "create", _CREATE)
+  // here ( - a) in bytes
+  WORD(here, 0, "here", _HERE)
+  // allot ( n - ) n bytes, to the cell
+  WORD(allot, 0, "allot", _ALLOT)
+  // variable
+  WORD(variable, 0, "variable", _VARIABLE)
+  // ?
+  WORD(question, 0, "?", _QUESTION)
+  // constant
+  WORD(constant, 0, "constant", _CONSTANT)
+  // R
+  WORD(r, 0, "R", _R)
+  // [
+  WORD(lbrac, IMMED, "[", _LBRAC)
+  // ]
+  WORD(rbrac, 0, "]", _RBRAC)
+  // :
+  WORD(colon, 0, ":", _COLON)
+  // ;
+  WORD(semi, IMMED, ";", _SEMI)
+  // i
+  WORD(i, 0, "i", _I)
+  // do
+  WORD(cdo, IMMED, "do", _CDO)
+  // loop
+  WORD(cloop, IMMED, "loop", _CLOOP)
+  // begin
+  WORD(cbegin, IMMED, "begin", _CBEGIN)
+  // until
+  WORD(cuntil, IMMED, "until", _CUNTIL)
+  // if
+  WORD(cif, IMMED, "if", _CIF)
+  // then
+  WORD(cthen, IMMED, "then", _CTHEN)
+  // else
+  WORD(celse, IMMED, "else", _CELSE)
+  // forget
+  WORD(forget, 0, "forget", _FORGET)
+  // '
+  WORD(tick, 0, "'", _TICK)
+  // again
+  WORD(cagain, IMMED, "again", _CAGAIN)
+  // while
+  WORD(cwhile, IMMED, "while", _CWHILE)
+  // repeat
+  WORD(crepeat, IMMED, "repeat", _CREPEAT)
+  // literal
+  WORD(cliteral, IMMED, "literal", _CLITERAL)
+  // c@ ( b - c)
+  WORD(cfetch, 0, "c@", _CFETCH)
+  // c! ( c b - )
+  WORD(cstore, 0, "c!", _CSTORE)
+  // type ( b c - ) one write; it was a c@ emit loop
+  WORD(type, 0, "type", _TYPE)
+  // warm (  - )
+  WORD(warm, 0, "warm", _WARM)
+
+  // wlist (  - )
+  WORD(wlist, 0, "wlist", _WLIST)
+
+  // fload (  - )
+  WORD(fload, 0, "fload", _FLOAD)
+
+// wag (  - )
+  WORD(wag, 0, "wag", _WAGDS)
+
+// wiggle ( n  - )
+  WORD(wiggle, 0, "wiggle", _WIGGLE)
+
+// rbyte ( adrs - n ) // consumes an address and returns a byte stored at that address
+  WORD(rbyte, 0, "rbyte", _RBYTE)
+
+// compose (  - )
+  WORD(cc, 0, "cc", _COMPOSE) // named as the 'cc' word for now - was 'compose' too long to type blind
+
+// s" ( -- addr )
+// length is found by another method.
+// squot squote s_quot s_quote _SQUOT _SQUOTE
+// gstr (  -- addr ) // get string
+  WORD(getstr, 0, "s\"", _GETSTR)
+
+// fs@ ( addr -- )
+// fs@  (  - ) // fetch string
+  WORD(fetchstr, 0, "fs@", _FETCHSTR)
+
+// cpmem ( addr ln - )
+  WORD(cpmem, 0, "cpmem", _COPYMEM)
+
+  WORD(thrown, 0, "throw", _THROWN) // throw
+
+  // code of 'type' subst. for real autoload aka 'uol' ( b c - )
+  // autoload: the boot runs it, from the cell after the code field
+  WORD_OF(uol, 0, "uol", _NOP) // 'uol' autoload
+  LABEL(autoload)
+  DATA(K_inits)
+  DATA(K_initr)
+  DATA(K_fload)
+  DATA(K_thrown)
+
+// new 05 sep
+// pmd pnw
+  WORD(pnmode, 0, "pnmode", _PINMODE) // 'pnmode' pinMode word
+
+  WORD(pnwrite, 0, "pnwrite", _PINWRITE) // 'pnwrite' pinMode word
+
+  // fuse ( - a) variable: 0 fuse ! compiles each word as written
+  WORD_OF(fuse, 0, "fuse", _DOVAR)
+  DATA(-1)
+
+  // save-image (  - ) the boot restores it, and skips the autoload
+  WORD(saveimage, 0, "save-image", _SAVEIMAGE)
+
+  // unlinked: what +loop and leave compile
+  CODE(plloop, _PLOOP)
+  CODE(lleave, _LEAVE)
+  // +loop ( n - )
+  WORD(cploop, IMMED, "+loop", _CPLOOP)
+  // leave - out of the loop, past its loop or +loop
+  WORD(cleave, IMMED, "leave", _CLEAVE)
+  // unloop - drop the loop, before an exit from inside it
+  WORD(unloop, 0, "unloop", _UNLOOP)
+  // j ( - n) index of the loop around this one
+  WORD(j, 0, "j", _J)
+  // move ( a1 a2 u - ) u bytes from a1 to a2, either may overlap
+  WORD(move, 0, "move", _MOVE)
+  // cmove ( b1 b2 u - ) u bytes from b1 to b2, low byte first
+  WORD(cmove, 0, "cmove", _CMOVE)
+  // cmove> ( b1 b2 u - ) high byte first
+  WORD(cmoveup, 0, "cmove>", _CMOVEUP)
+  // fill ( b u c - ) u bytes of c from b
+  WORD(fill, 0, "fill", _FILL)
+  // erase ( b u - ) u bytes of 0 from b
+  WORD(erase, 0, "erase", _ERASE)
+  // profile-on ( - ) count and time words, in a PROFILE build
+  WORD(profon, 0, "profile-on", _PROFON)
+  // profile-off ( - )
+  WORD(profoff, 0, "profile-off", _PROFOFF)
+  // profile-reset ( - )
+  WORD(profreset, 0, "profile-reset", _PROFRESET)
+  // .profile ( n - ) the n words with the most time
+  WORD(dotprofile, 0, ".profile", _DOTPROFILE)
+  // ( - ) the trace held, at the ~ of the file interpreter
+  CODE(tracehold, _TRACEHOLD)
+  // .trace ( - ) the last instructions run, in a TRACE build
+  WORD(dottrace, 0, ".trace", _DOTTRACE)
+  // micros ( - n) microseconds since boot, for timing
+  WORD(micros, 0, "micros", _MICROS)
+  // .name ( a - ) the name of the word with header a, as ' and find give
+  WORD(dotname, 0, ".name", _DOTNAME)
+  // pause ( - ) the next task awake runs; this one, after the rest
+  WORD(pause, 0, "pause", _PAUSE)
+  // stop ( - ) the task running sleeps, and pauses
+  WORD(stop, 0, "stop", _STOP)
+  // activate ( a - ) task a runs the rest of this definition, from
+  // empty stacks, and this one returns to its caller
+  WORD(activate, 0, "activate", _ACTIVATE)
+  // task ( - ) task t1  makes t1 ( - a), the block of a new task
+  WORD(task, 0, "task", _TASK)
+  // key and parse, waiting on the keyboard: _KEY and _PARSE nest
+  // in here when there is nothing to read, and go round until
+  // there is - the other tasks run meanwhile
+  CODE_OF(keywait, _NEST)
+  DATA(K_pause)
+  DATA(K_key)
+  DATA(K_exit)
+  CODE_OF(parsewait, _NEST)
+  DATA(K_pause)
+  DATA(K_parse)
+  DATA(K_exit)
+  // under a task's first return: a task that gets to the end of
+  // what activate gave it stops there
+  LABEL(taskend)
+  DATA(K_stop)
+  DATA(K_branch)
+  DATA(K_taskend)
+
+  WORD(keyq, 0, "key?", _KEYQ)
+
+  WORD(flush, 0, "flush", _FLUSH)
+
+  WORD(hdump, 0, "hdump", _HDUMP) // ( b u - ) dumpram.cpp
+
+  WORD(rdump, 0, "rdump", _RDUMP) // ( a u - )
+
+  WORD(unused, 0, "unused", _UNUSED) // ( - u) bytes
+
+  WORD(stackroom, 0, "stack-room", _STACKROOM) // ( - s r) cells
+
+  WORD(pad, 0, "pad", _PAD)
+
+/*  not loaded: a test loop, once put above the kernel by setup ()
+    and run from there by hand (I = its first cell)
+
+  // test
+  LABEL(test)
+  DATA(K_lit)
+  DATA(10) // i
+  DATA(K_lit)
+  DATA(0) // i
+  DATA(K_ddo)
+  LABEL(test_loop)
+  DATA(K_i)
+  DATA(K_dot)
+  DATA(K_lloop)
+  DATA(K_test_loop)
+  DATA(K_r)
+  DATA(K_dot)
+  DATA(K_ddots)
+  DATA(K_cr)
+  DATA(K_branch)
+  DATA(K_test) // return to top of this code block
+*/
+
+#undef CODE
+#undef WORD
+#undef PRIM
+#undef CODE_OF
+#undef WORD_OF
+#undef LABEL
+#undef DATA
@@ -105,6 +105,42 @@ void mkdir_forth(void) {
 
 void blink_awaiting_serial(void) { }
 
+Print *forth_out = &thisFile;
+
+// a Print that keeps only the hash and length of what it is sent
+class HashPrint : public Print {
+public:
+  uint32_t h;
+  uint32_t len;
+  HashPrint(void) : h(IMAGE_HASH), len(0) { }
+  using Print::write;
+  size_t write(uint8_t c) {
+    h = image_hash(&c, 1, h);
+    len++;
+    return 1;
+  }
+};
+
+// does thisFile, open on FILE_NAME, hold what sum was taken of?
+boolean boot_file_current(HashPrint *sum) {
+  uint32_t was[2]; // hash, size
+  if (!thisFile || (thisFile.size() != sum->len)) return false;
+  File f = fatfs.open(BOOT_SUM_NAME, FILE_READ);
+  if (!f) return false;
+  int n = f.read(was, sizeof(was));
+  f.close();
+  return (n == (int) sizeof(was)) && (was[0] == sum->h) && (was[1] == sum->len);
+}
+
+void boot_sum_write(HashPrint *sum) {
+  uint32_t was[2] = { sum->h, sum->len };
+  fatfs.remove(BOOT_SUM_NAME); // FILE_WRITE appends
+  File f = fatfs.open(BOOT_SUM_NAME, FILE_WRITE);
+  if (!f) return;
+  f.write((const uint8_t *) was, sizeof(was));
+  f.close();
+}
+
 void flash_setup(void) {
   // Open serial communications and wait for port to open:
   Serial.begin(38400);
@@ -132,98 +168,74 @@ void flash_setup(void) {
 #endif // #ifdef VERBIAGE_AA
 
 
-  if (!fatfs.remove(FILE_NAME)) {
-    Serial.print("Failed to remove "); Serial.println(FILE_NAME);
-  }
-
+  // the boot file: what forth_words () and sam_editor () write is
+  // hashed first, and written to flash only when what is there was
+  // written from something else - BOOT_SUM_NAME says what
 
+  HashPrint sum;
+  forth_out = &sum;
+  forth_words();
+  sam_editor(); // future: sam.fs and named file loading
+  forth_out = &thisFile;
+  boot_hash = sum.h; // for save-image
 
 #ifdef WANT_MKDIR_FORTH
   mkdir_forth(); // tnr kludge
 #endif // #ifdef WANT_MKDIR_FORTH
 
-  // open the file. note that only one file can be open at a time,
-  // so you have to close this one before opening another.
-  myFile = fatfs.open(FILE_NAME, FILE_WRITE);
-
-  thisFile = (File) myFile; // local tnr kludge
-
-  // if the file opened okay, write to it:
-// if (myFile) {
-   if (thisFile) {
+  thisFile = fatfs.open(FILE_NAME, FILE_READ);
+  if (boot_file_current(&sum)) {
 #ifdef VERBIAGE_AA
-    Serial.print("Writing to "); Serial.print(FILE_NAME); Serial.print(" ");
+    Serial.print(FILE_NAME); Serial.println(" is up to date - not written.");
 #else
-    Serial.print(" ckpt CC ");
+    Serial.print(" ckpt CC= ");
 #endif // #ifdef VERBIAGE_AA
+  } else {
+    if (thisFile) thisFile.close();
+    if (!fatfs.remove(FILE_NAME)) {
+      Serial.print("Failed to remove "); Serial.println(FILE_NAME);
+    }
 
-// file contents - - - - - - - - - - - - - - - -
-
-    forth_words();
-    sam_editor(); // future: sam.fs and named file loading
-
-// file contents - - - - - - - - - - - - - - - -
+    // open the file. note that only one file can be open at a time,
+    // so you have to close this one before opening another.
+    thisFile = fatfs.open(FILE_NAME, FILE_WRITE);
 
-    // close the file:
-    // myFile.close();
-    thisFile.close();
+    // if the file opened okay, write to it:
+    if (thisFile) {
 #ifdef VERBIAGE_AA
-    Serial.println(" has now been done.");
+      Serial.print("Writing to "); Serial.print(FILE_NAME); Serial.print(" ");
 #else
-    Serial.print(" ckpt DD ");
+      Serial.print(" ckpt CC ");
 #endif // #ifdef VERBIAGE_AA
-  } else {
-    // if the file didn't open, print an error:
-    Serial.print("error opening "); Serial.println(FILE_NAME);
-  }
 
-  // re-open the file for reading:
+// file contents - - - - - - - - - - - - - - - -
 
-  myFile = fatfs.open(FILE_NAME);
-  // thisFile = (File) myFile; // local tnr kludge
+      forth_words();
+      sam_editor(); // future: sam.fs and named file loading
 
-  if (myFile) {
-#ifdef VERBIAGE_AA
-    Serial.print(FILE_NAME); Serial.println(" .. will now be read and printed");
-    Serial.println("to the console.  Attention: design has strange line endings!\r\n");
-#else
-    Serial.print(" ckpt EE ");
-#endif // #ifdef VERBIAGE_AA
+// file contents - - - - - - - - - - - - - - - -
 
-    // read from the file until there's nothing else in it:
-    while (myFile.available()) {
+      thisFile.close();
+      boot_sum_write(&sum);
 #ifdef VERBIAGE_AA
-      Serial.write(myFile.read());
+      Serial.println(" has now been done.");
 #else
-#ifdef FBUFF_PRN // suppress when undefined
-      Serial.print("+");
-#endif
-      int ij = myFile.read(); // do the read anyway - try to break something
+      Serial.print(" ckpt DD ");
 #endif // #ifdef VERBIAGE_AA
+    } else {
+      // if the file didn't open, print an error:
+      Serial.print("error opening "); Serial.println(FILE_NAME);
     }
-    // close the file:
-    myFile.close();
-#ifdef VERBIAGE_AA
-    Serial.println("\r\n");
-    Serial.print(FILE_NAME); Serial.println(" .. is now closed, safely.");
-#else
-    Serial.print(" ckpt FF ");
-#endif // #ifdef VERBIAGE_AA
 
     // re-open the file for reading:
+    thisFile = fatfs.open(FILE_NAME, FILE_READ);
+  }
 
-    File dataFile = fatfs.open(FILE_NAME, FILE_READ);
+  if (thisFile) {
+    lex_reset(); // a new file for _FLPARSE
 #ifdef VERBIAGE_AA
     Serial.print(FILE_NAME);
-    Serial.println(" is now re-opened (for reading).");
-#else
-    Serial.print(" ckpt GG ");
-#endif // #ifdef VERBIAGE_AA
-
-    thisFile = (File) dataFile;
-    thisFile.rewind();
-#ifdef VERBIAGE_AA
-    Serial.println("FILE STAYS OPEN (and rewound) (for a possible fload).");
+    Serial.println(" is open (for reading) - for a possible fload.");
 #else
     Serial.print(" ckpt HH ");
 #endif // #ifdef VERBIAGE_AA
@@ -232,3 +244,4 @@ void flash_setup(void) {
     Serial.print("error opening "); Serial.println(FILE_NAME);
   }
 }
+
@@ -130,18 +130,14 @@ C20 18 00 00 00 19 00 00 00 1A 00 00 00 1B 00 00 00 ................
 // rhlist ( addr -- )
       WRITE_VERT_WSPACE( "  "
 
-    ) WRITELN_FORTH(     ": rhlist hadr 16 + dup 16 - over over "
+    ) WRITELN_FORTH(     ": rhlist hadr 16 + dup dup 16 - "
     ) WRITELN_FORTH(     "  do "
-    ) WRITELN_FORTH(     "      1 + over over swap - 1 - "
+    ) WRITELN_FORTH(     "      i 1 + rbyte dup 16 - "
     ) WRITELN_FORTH(     "      0< if "
-    ) WRITELN_FORTH(     "          dup rbyte dup 16 - "
-    ) WRITELN_FORTH(     "          0< if "
-    ) WRITELN_FORTH(     "              48 emit "
-    ) WRITELN_FORTH(     "          then "
-    ) WRITELN_FORTH(     "          h. 100 delay "
+    ) WRITELN_FORTH(     "          48 emit "
     ) WRITELN_FORTH(     "      then "
-    ) WRITELN_FORTH(     "  loop "
-    ) WRITELN_FORTH(     "  drop ;"
+    ) WRITELN_FORTH(     "      h. 100 delay "
+    ) WRITELN_FORTH(     "  loop ;"
 
 // --- all above good 03 SEP 2019
 
@@ -156,41 +152,32 @@ C20 18 00 00 00 19 00 00 00 1A 00 00 00 1B 00 00 00 ................
 //  ) WRITELN_FORTH(     "  "
 
     ) WRITELN_FORTH(     ": ralist"
-    ) WRITELN_FORTH(     "  space space 16 + dup 16 - over over"
+    ) WRITELN_FORTH(     "  space space 16 + dup dup 16 -"
     ) WRITELN_FORTH(     "  do"
-    ) WRITELN_FORTH(     "      1 + over over swap - 1 -"
-    ) WRITELN_FORTH(     "      0< if"
-    ) WRITELN_FORTH(     "          dup rbyte >prn 100 delay"
-    ) WRITELN_FORTH(     "      then"
-    ) WRITELN_FORTH(     "  loop drop ;" )
+    ) WRITELN_FORTH(     "      i 1 + rbyte >prn 100 delay"
+    ) WRITELN_FORTH(     "  loop ;" )
 
 // hlist ( addr -- )
 //  ) WRITELN_FORTH(     "  "
       WRITE_VERT_WSPACE(  "  "
     ) WRITELN_FORTH(     ": hlist"
-    ) WRITELN_FORTH(     "  hadr 16 + dup 16 - over over"
+    ) WRITELN_FORTH(     "  hadr 16 + dup dup 16 -"
     ) WRITELN_FORTH(     "  do"
-    ) WRITELN_FORTH(     "      1 + over over swap - 1 -"
+    ) WRITELN_FORTH(     "      i 1 + c@ dup 16 -"
     ) WRITELN_FORTH(     "      0< if"
-    ) WRITELN_FORTH(     "          dup c@ dup 16 -"
-    ) WRITELN_FORTH(     "          0< if"
-    ) WRITELN_FORTH(     "              48 emit"
-    ) WRITELN_FORTH(     "          then"
-    ) WRITELN_FORTH(     "          h. 100 delay"
+    ) WRITELN_FORTH(     "          48 emit"
     ) WRITELN_FORTH(     "      then"
-    ) WRITELN_FORTH(     "  loop drop ;"
+    ) WRITELN_FORTH(     "      h. 100 delay"
+    ) WRITELN_FORTH(     "  loop ;"
 
     ) WRITE_VERT_WSPACE( "  "
 
 // alist ( addr -- )
     ) WRITELN_FORTH(     ": alist"
-    ) WRITELN_FORTH(     "  space space 16 + dup 16 - over over"
+    ) WRITELN_FORTH(     "  space space 16 + dup dup 16 -"
     ) WRITELN_FORTH(     "  do"
-    ) WRITELN_FORTH(     "      1 + over over swap - 1 -"
-    ) WRITELN_FORTH(     "      0< if"
-    ) WRITELN_FORTH(     "          dup c@ >prn 100 delay"
-    ) WRITELN_FORTH(     "      then"
-    ) WRITELN_FORTH(     "  loop drop ;"
+    ) WRITELN_FORTH(     "      i 1 + c@ >prn 100 delay"
+    ) WRITELN_FORTH(     "  loop ;"
 
     ) WRITE_VERT_WSPACE( "  "
 
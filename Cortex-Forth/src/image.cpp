@@ -0,0 +1,296 @@
+// image.cpp  the compiled dictionary, saved to flash and restored at boot
+
+/*
+  save-image writes memory.data [0 .. H), H and D to IMAGE_NAME.
+  At the next boot, image_load () reads them back in one go, in
+  place of the autoload: the boot file is not compiled again.
+
+  A code field holds the number of a primitive (vm.h), not its
+  address, so the cells are written as they are; a rebuild of the
+  firmware that moves the primitives around leaves them good.  The
+  header says what the image was made against, and it is only
+  loaded when that still holds:
+
+    prims    PRIM_COUNT - primitives added since, at the end of the
+             list, are fine; fewer than the image knows of is not
+    ram      RAM_SIZE
+    kernel   hash of the dictionary setup () builds, cells 0 .. its H:
+             every address the image holds into the kernel
+    source   hash of the boot file flash_setup () wrote (boot_hash)
+    sum      hash of the cells themselves
+*/
+
+#include <Arduino.h>
+#include "SdFat.h"
+#include "../vm.h"
+#include "../common.h"
+
+extern FatFileSystem fatfs; // flash_ops.cpp
+
+#define IMAGE_MAGIC 0x31494643 // "CFI1"
+
+struct image_head {
+  uint32_t magic;
+  uint32_t prims;
+  uint32_t ram;
+  uint32_t kernel;
+  uint32_t source;
+  int32_t H;
+  int32_t D;
+  uint32_t sum;
+};
+
+uint32_t boot_hash = 0;          // of the boot file, set by flash_setup ()
+static uint32_t kernel_hash = 0; // set by image_kernel ()
+static int kernel_H = 0;
+
+uint32_t image_hash (const void *p, int n, uint32_t h) { // FNV-1a
+  const unsigned char *b = (const unsigned char *) p;
+  for (int i = 0; i < n; i++) {
+    h ^= b [i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+// setup () has built the kernel: note what it looks like
+void image_kernel (void) {
+  kernel_H = H;
+  kernel_hash = image_hash (memory.data, H * sizeof (int), IMAGE_HASH);
+}
+
+boolean image_save (void) {
+  struct image_head head;
+  head.magic = IMAGE_MAGIC;
+  head.prims = PRIM_COUNT;
+  head.ram = RAM_SIZE;
+  head.kernel = kernel_hash;
+  head.source = boot_hash;
+  head.H = H;
+  head.D = D;
+  head.sum = image_hash (memory.data, H * sizeof (int), IMAGE_HASH);
+
+  fatfs.remove (IMAGE_NAME); // FILE_WRITE appends
+  File f = fatfs.open (IMAGE_NAME, FILE_WRITE);
+  if (!f) return false;
+  size_t n = f.write ((const uint8_t *) &head, sizeof (head));
+  n += f.write ((const uint8_t *) memory.data, H * sizeof (int));
+  f.close ();
+  if (n == (sizeof (head) + H * sizeof (int))) return true;
+  fatfs.remove (IMAGE_NAME);
+  return false;
+}
+
+// true: the dictionary is the one in the image
+boolean image_load (void) {
+  struct image_head head;
+  File f = fatfs.open (IMAGE_NAME, FILE_READ);
+  if (!f) return false;
+  boolean good = (f.read (&head, sizeof (head)) == (int) sizeof (head)) &&
+                 (head.magic == IMAGE_MAGIC) &&
+                 (head.prims <= PRIM_COUNT) &&
+                 (head.ram == RAM_SIZE) &&
+                 (head.kernel == kernel_hash) &&
+                 (head.source == boot_hash) &&
+                 (head.H >= kernel_H) && (head.H <= DICT_CELLS) &&
+                 (head.D > 0) && (head.D < head.H) &&
+                 (f.size () == (sizeof (head) + head.H * sizeof (int)));
+  if (!good) {
+    f.close ();
+    return false;
+  }
+  int n = f.read (memory.data, head.H * sizeof (int));
+  f.close ();
+  if ((n != (int) (head.H * sizeof (int))) ||
+      (image_hash (memory.data, n, IMAGE_HASH) != head.sum)) {
+    // the kernel is gone too: start over, without the image
+    Serial.println (" bad image - removed, restarting");
+    fatfs.remove (IMAGE_NAME);
+    NVIC_SystemReset ();
+  }
+  H = head.H;
+  D = head.D;
+  dict_rehash ();
+  return true;
+}
+
+/*
+  fload keeps what it compiles, too.  _FLOAD notes the dictionary as
+  the file finds it (seg_begin), and when the file has been read to
+  its end, seg_save () writes the cells it added - the old H up to
+  the new - with the new D and base, to SEGMENT_NAME, next to
+  FILE_NAME.  A later fload of the same file onto the same
+  dictionary reads them back (seg_load) in place of compiling it.
+
+  The segment is keyed as the image is (prims, ram), and by
+
+    source   hash and length of the file's bytes, as read at fload
+    dict     hash of cells 0 .. H, and H, D and base
+    stack    hash of the data stack, T and depth
+
+  It only ever goes back in at the H it was compiled at, so there
+  is nothing in it to relocate.
+
+  A load that did more than add to the dictionary is not kept: one
+  that trapped, activated a task, stored below the old H, left the
+  stack otherwise than it found it, or ended inside a definition.
+  What the file printed as it was compiled - a ~ for a word it did
+  not know, too - is not printed again.  A file that reads the
+  keyboard, the pins or the clock as it loads gets what they gave
+  the first time: remove SEGMENT_NAME to have it compiled again.
+
+  On the host, the H each ; left goes into the segment too, and the
+  words are compiled to native code again (-n) in the order they
+  were made.
+*/
+
+#ifdef HOST_NATIVE
+#include "native.h"
+#define SEG_ENDS 512 // colon definitions a segment compiles natively
+#else
+#define SEG_ENDS 1   // none: there is no native code
+#endif // #ifdef HOST_NATIVE
+
+#define SEG_MAGIC 0x31534643 // "CFS1"
+
+struct seg_head {
+  uint32_t magic;
+  uint32_t prims;
+  uint32_t ram;
+  uint32_t source; // the file
+  uint32_t size;
+  uint32_t dict;   // cells 0 .. from
+  uint32_t stack;  // and the data stack
+  int32_t from;    // H, D and base the file found
+  int32_t D0;
+  int32_t base0;
+  int32_t H;       // and left
+  int32_t D;
+  int32_t base;
+  int32_t ends;    // pairs in seg_ends []: code field, H after its ;
+  uint32_t sum;    // cells from .. H
+};
+
+static struct seg_head seg; // the load under way
+static boolean seg_on = false;
+
+// the data stack, T and depth, as a hash
+static uint32_t seg_stack (void) {
+  int32_t top [2] = { vm.T, task_s0 - vm.S };
+  uint32_t h = image_hash (top, sizeof (top), IMAGE_HASH);
+  if ((vm.S >= 0) && (vm.S < task_s0) && (task_s0 <= RAM_SIZE))
+    h = image_hash (&memory.data [vm.S], (task_s0 - vm.S) * sizeof (int), h);
+  return h;
+}
+static int32_t seg_ends [2 * SEG_ENDS];
+
+// _FLOAD: thisFile is to be read from the start
+void seg_begin (int base) {
+  seg_on = false;
+  if (!thisFile || thisFile.position ()) return;
+  uint8_t buf [LEX_SECTOR];
+  uint32_t h = IMAGE_HASH;
+  int n;
+  while ((n = thisFile.read (buf, sizeof (buf))) > 0) h = image_hash (buf, n, h);
+  if (!thisFile.seek (0)) return;
+  lex_reset ();
+  seg.magic = SEG_MAGIC;
+  seg.prims = PRIM_COUNT;
+  seg.ram = RAM_SIZE;
+  seg.source = h;
+  seg.size = thisFile.size ();
+  seg.dict = image_hash (memory.data, H * sizeof (int), IMAGE_HASH);
+  seg.from = H;
+  seg.D0 = D;
+  seg.base0 = base;
+  seg.stack = seg_stack ();
+  seg.ends = 0;
+  seg_on = true;
+}
+
+// the load went wrong, or did what a segment cannot hold
+void seg_drop (void) {
+  seg_on = false;
+}
+
+// _SEMI: the word at cfa ends at H
+void seg_semi (int cfa) {
+#ifdef HOST_NATIVE
+  if (!seg_on || (seg.ends >= SEG_ENDS)) return;
+  seg_ends [2 * seg.ends] = cfa;
+  seg_ends [2 * seg.ends + 1] = H;
+  seg.ends++;
+#endif // #ifdef HOST_NATIVE
+}
+
+// true: this load's segment is in, and *base is as it left it
+boolean seg_load (int *base) {
+  if (!seg_on) return false;
+  struct seg_head head;
+  File f = fatfs.open (SEGMENT_NAME, FILE_READ);
+  if (!f) return false;
+  boolean good = (f.read (&head, sizeof (head)) == (int) sizeof (head)) &&
+                 (head.magic == SEG_MAGIC) &&
+                 (head.prims <= PRIM_COUNT) &&
+                 (head.ram == RAM_SIZE) &&
+                 (head.source == seg.source) && (head.size == seg.size) &&
+                 (head.dict == seg.dict) && (head.stack == seg.stack) &&
+                 (head.from == seg.from) &&
+                 (head.D0 == seg.D0) && (head.base0 == seg.base0) &&
+                 (head.H > head.from) && (head.H <= DICT_CELLS) &&
+                 (head.D >= head.from) && (head.D < head.H) &&
+                 (head.ends >= 0) && (head.ends <= SEG_ENDS) &&
+                 (f.size () == (sizeof (head) + head.ends * 2 * sizeof (int32_t) +
+                                (head.H - head.from) * sizeof (int)));
+  if (!good) {
+    f.close ();
+    return false;
+  }
+  int cells = head.H - head.from;
+  int n = f.read (seg_ends, head.ends * 2 * sizeof (int32_t));
+  n += f.read (&memory.data [head.from], cells * sizeof (int));
+  f.close ();
+  if ((n != (int) (head.ends * 2 * sizeof (int32_t) + cells * sizeof (int))) ||
+      (image_hash (&memory.data [head.from], cells * sizeof (int), IMAGE_HASH) != head.sum)) {
+    // only the free cells above H were written: compile the file instead
+    fatfs.remove (SEGMENT_NAME);
+    return false;
+  }
+  seg_on = false;
+  H = head.H;
+  D = head.D;
+  *base = head.base;
+  dict_rehash ();
+#ifdef HOST_NATIVE
+  for (int i = 0; i < head.ends; i++) { // native_compile () takes H as the word's end
+    H = seg_ends [2 * i + 1];
+    native_compile (seg_ends [2 * i]);
+  }
+  H = head.H;
+#endif // #ifdef HOST_NATIVE
+  return true;
+}
+
+// thisFile has been read to its end, and closed: keep what it added
+void seg_save (int base) {
+  if (!seg_on) return;
+  seg_on = false;
+  if ((H <= seg.from) || (D < seg.from) || (D >= H) ||
+      (seg_stack () != seg.stack) ||
+      (image_hash (memory.data, seg.from * sizeof (int), IMAGE_HASH) != seg.dict)) return;
+  int cells = H - seg.from;
+  seg.H = H;
+  seg.D = D;
+  seg.base = base;
+  seg.sum = image_hash (&memory.data [seg.from], cells * sizeof (int), IMAGE_HASH);
+
+  fatfs.remove (SEGMENT_NAME); // FILE_WRITE appends
+  File f = fatfs.open (SEGMENT_NAME, FILE_WRITE);
+  if (!f) return;
+  size_t n = f.write ((const uint8_t *) &seg, sizeof (seg));
+  n += f.write ((const uint8_t *) seg_ends, seg.ends * 2 * sizeof (int32_t));
+  n += f.write ((const uint8_t *) &memory.data [seg.from], cells * sizeof (int));
+  f.close ();
+  if (n != (sizeof (seg) + seg.ends * 2 * sizeof (int32_t) + cells * sizeof (int)))
+    fatfs.remove (SEGMENT_NAME);
+}
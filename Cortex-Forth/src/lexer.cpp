@@ -0,0 +1,69 @@
+// lexer.cpp  tokens from thisFile, read a sector at a time
+
+/*
+  _FLPARSE asks lex_next () for the next token of the file being
+  loaded.  The file is read LEX_SECTOR bytes at a go into lex_buf,
+  and a token comes back as a pointer into lex_buf and a length -
+  good until the next call.  Anything up to ' ' (space, tab, CR,
+  LF) separates tokens, and a token starting with a backslash
+  starts a comment, which runs to the end of the line.
+
+  A token that runs off the end of the buffer is moved to the front
+  of it, and the next sector read in behind it, so tokens never
+  straddle the buffer's end.  One longer than LEX_TOKEN_MAX is cut.
+*/
+
+#include "../common.h"
+
+static char lex_buf [LEX_TOKEN_MAX + LEX_SECTOR];
+static int lex_pos = 0; // next byte to look at
+static int lex_len = 0; // bytes in lex_buf
+
+// keep lex_buf [keep .. lex_len), moved to the front, and read a
+// sector in behind it.  Returns bytes read: 0 at end of file.
+static int lex_fill (int keep) {
+  int n = lex_len - keep;
+  memmove (lex_buf, lex_buf + keep, n);
+  lex_pos -= keep;
+  lex_len = n;
+  int got = thisFile.read (lex_buf + n, LEX_SECTOR);
+  if (got <= 0) return 0;
+  lex_len += got;
+  return got;
+}
+
+void lex_reset (void) {
+  lex_pos = 0;
+  lex_len = 0;
+}
+
+// the next token: its length, with *tok pointing at it; -1 at end of file
+int lex_next (const char **tok) {
+  for (;;) {
+    while ((lex_pos < lex_len) && ((unsigned char) lex_buf [lex_pos] <= ' ')) lex_pos++;
+    if (lex_pos == lex_len) {
+      if (!lex_fill (lex_pos)) return -1;
+      continue;
+    }
+    if (lex_buf [lex_pos] == '\\') { // comment, to the end of the line
+      for (;;) {
+        while ((lex_pos < lex_len) && (lex_buf [lex_pos] != '\r') && (lex_buf [lex_pos] != '\n')) lex_pos++;
+        if (lex_pos < lex_len) break;
+        if (!lex_fill (lex_pos)) return -1;
+      }
+      continue;
+    }
+    int start = lex_pos;
+    for (;;) {
+      while ((lex_pos < lex_len) && ((unsigned char) lex_buf [lex_pos] > ' ')) lex_pos++;
+      if (lex_pos < lex_len) break;              // found its end
+      if ((lex_pos - start) >= LEX_TOKEN_MAX) break; // cut it here
+      int moved = start;
+      int got = lex_fill (start);
+      start -= moved;
+      if (!got) break;                           // end of file ends it
+    }
+    *tok = lex_buf + start;
+    return lex_pos - start;
+  }
+}
@@ -0,0 +1,134 @@
+// profile.cpp  executions and time per word, for a PROFILE build
+
+/*
+  With PROFILE defined and profile-on typed, vm_run calls in here
+  (the PROF_ hooks in vm.h) for every instruction it dispatches,
+  and on the way into and out of every colon definition.
+
+  count  times the word was executed - from a colon definition, or
+         by the interpreter
+  self   time in the colon definition's own instructions, not in
+         the words it calls: the clock is read at each nest and
+         exit.  A primitive runs inside the word that has it, so
+         its time is that word's.  The interpreter's own loop, and
+         its wait for the keyboard, are charged to no one.
+
+  The clock: the DWT cycle counter on the M4 (SAMD51), micros ()
+  on the M0, a monotonic ns clock on the host.  The time taken by
+  the counting itself is in there too, spread over everything.
+
+  Words are kept in a table hashed on the code field.  When it is
+  full a new word is not counted; prof_lost says how often.  The
+  colon definition each frame on the return stack came back to is
+  in prof_caller [], by its place on the return stack.
+*/
+
+#include <Arduino.h>
+#include "../vm.h"
+#include "../common.h"
+
+#ifdef PROFILE
+
+#if defined(HOST_BUILD)
+#define PROF_CLOCK() ((uint32_t) host_nanos ())
+const char *const prof_unit = "ns";
+#elif defined(__SAMD51__)
+#define PROF_CLOCK() (DWT->CYCCNT)
+const char *const prof_unit = "cycles";
+#else
+#define PROF_CLOCK() ((uint32_t) micros ())
+const char *const prof_unit = "us";
+#endif
+
+int profiling = 0;
+int prof_lost = 0;
+
+static struct prof_entry prof_table [PROF_SLOTS];
+static int prof_caller [RSTACK_CELLS];  // by R0 - R, for a frame nest pushed
+static int prof_cur = 0;               // colon definition running, 0: the interpreter
+static uint32_t prof_last = 0;         // clock when prof_cur last took over
+
+static struct prof_entry *prof_find (int cfa) { // 0 if the table is full
+  unsigned int i = ((unsigned int) cfa * 2654435761u) >> (32 - PROF_BITS);
+  for (int n = 0; n < PROF_SLOTS; n++) {
+    struct prof_entry *e = &prof_table [i];
+    if (e->cfa == cfa) return e;
+    if (!e->cfa) {
+      e->cfa = cfa;
+      return e;
+    }
+    i = (i + 1) & (PROF_SLOTS - 1);
+  }
+  prof_lost++;
+  return 0;
+}
+
+// the time since the last look at the clock goes to prof_cur
+static void prof_charge (void) {
+  uint32_t now = PROF_CLOCK ();
+  if (prof_cur) {
+    struct prof_entry *e = prof_find (prof_cur);
+    if (e) e->self += now - prof_last;
+  }
+  prof_last = now;
+}
+
+void prof_count (int cfa) {
+  struct prof_entry *e = prof_find (cfa);
+  if (e) e->count++;
+}
+
+void prof_nest (int cfa, int r) {
+  prof_charge ();
+  unsigned int k = R0 - r;
+  if (k < (sizeof (prof_caller) / sizeof (prof_caller [0]))) prof_caller [k] = prof_cur;
+  prof_cur = cfa;
+}
+
+void prof_exit (int r) {
+  prof_charge ();
+  unsigned int k = R0 - r;
+  prof_cur = (k < (sizeof (prof_caller) / sizeof (prof_caller [0]))) ? prof_caller [k] : 0;
+}
+
+void prof_initr (void) {
+  prof_charge ();
+  prof_cur = 0;
+}
+
+void prof_on (void) {
+#if defined(__SAMD51__) && !defined(HOST_BUILD)
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+  memset (prof_caller, 0, sizeof (prof_caller)); // frames from before: the interpreter's
+  prof_cur = 0;
+  prof_last = PROF_CLOCK ();
+  profiling = -1;
+}
+
+void prof_reset (void) {
+  memset (prof_table, 0, sizeof (prof_table));
+  prof_lost = 0;
+  prof_last = PROF_CLOCK ();
+}
+
+// is a further down the list than b: less time, then fewer
+// executions, then the higher code field
+static boolean prof_below (const struct prof_entry *a, const struct prof_entry *b) {
+  if (a->self != b->self) return a->self < b->self;
+  if (a->count != b->count) return a->count < b->count;
+  return a->cfa > b->cfa;
+}
+
+const struct prof_entry *prof_next (const struct prof_entry *e) {
+  const struct prof_entry *best = 0;
+  for (int i = 0; i < PROF_SLOTS; i++) {
+    const struct prof_entry *x = &prof_table [i];
+    if (!x->cfa || (e && !prof_below (x, e))) continue;
+    if (!best || prof_below (best, x)) best = x;
+  }
+  return best;
+}
+
+#endif // #ifdef PROFILE
@@ -27,15 +27,15 @@ void sam_editor(void) {
 // immediate:
       WRITE_VERT_WSPACE(  "  "
     ) WRITE_VERT_WSPACE(  "  "
-    )   WRITELN_FORTH(     "2048 allot " // 18k address space 03 SEP 2019
+    )   WRITELN_FORTH(     "8192 allot " // 18k address space 03 SEP 2019 - allot is in bytes
     )   WRITELN_FORTH(     "variable bend variable buff here buff ! "
     )   WRITELN_FORTH(     "variable bend variable buff here buff ! "
-    )   WRITELN_FORTH(     "2048 allot here bend ! 1 drop "
+    )   WRITELN_FORTH(     "8192 allot here bend ! 1 drop "
     ) WRITE_VERT_WSPACE(  "  "
     ) WRITELN_FORTH(     ": svd buff @ 2701 + blist ;"  // so adding a 'cr' to the end of the line faked out the parser into not seeing a single character entity as the last entity on the line. ;)
     ) WRITELN_FORTH(     ": sve buff @ 4 + cr ;"
     ) WRITE_VERT_WSPACE(  "  "
-    ) WRITELN_FORTH(     ": goa svd sve 26 0 do 1 + 32 i + over ! loop cr cr svd cr ;"
+    ) WRITELN_FORTH(     ": goa svd sve 26 0 do 4 + 32 i + over ! loop cr cr svd cr ;"
     ) WRITE_VERT_WSPACE(  "  " )
 
 // review:  value address !
@@ -20,7 +20,9 @@ extern void _HERE(void);
 extern void _SWAP(void);
 extern void _DROP(void);
 extern int _COMPOSE(void);
+extern int parse_char(void);
 extern void _KEY(void);
+extern Print *console_out; // Cortex-Forth.ino: the port, output buffered
 extern void _DUP(void);
 extern void _CSTORE (void);
 extern void _CFETCH (void);
@@ -138,19 +140,20 @@ void cpMem2Str(void) { // ( addr ln -- )
     length = pop();
     // char* memAdrs = (char *) pop();
     int adrs = pop();
-    const void* cvp = (const void*) adrs;
 //  char* address = (char*) adrs;
 //  char* memAdrs = address;
 //  memcpy(instring, &memAdrs, length);
 
 #ifdef WAS_LATEST_STRING_THING
+    const void* cvp = (const void*) (intptr_t) adrs;
     memcpy(instring, cvp, length);
 #else
+    (void) adrs;
     // memcpy(instring, myAlphaCcp, 22);
     memcpy(instring, myAlphaCcp, length);
-Serial.println(instring);
+console_out->println(instring);
 #endif
-    push((int)&instring); // notha wileguess
+    push((int)(intptr_t)&instring); // notha wileguess
 }
 /*
      TEF MEK Hn-f
@@ -297,6 +300,10 @@ junk:
 
 */
 
+// s" ( - adrs ) the rest of the input up to the closing quote, or
+// the end of the line.  At adrs: its length, then the chars last
+// first (fs@ and emits turn them round again), then a 0
+#define STRMAX 29 // 32 allot'd: adrs is one in, and the 0
 void parseStr(void) {
     _HERE();
     push(32);
@@ -304,36 +311,32 @@ void parseStr(void) {
     _HERE();
     _SWAP();
     int n = pop(); // bottom address of new string allot'd
+    _DROP();
     n++; // might want to skip that first byte haha
 
-    /* note: no clue as to what has to stay and what can profitably be removed: */
-    char* cStr = (char*) n;
-    char* str = 0;
-    if(cStr) {
-        *cStr++;
-        _COMPOSE(); // _KEY();
-        // Serial.println("DEBUG intercept AA in parseStr() ");
-        int ln = pop();
-        ln--; // not ascii 32 delimiter
-        int p = n;
-        for (int i = ln; i>0; i--) {
-            _DUP(); int test = pop();
-
-            if (test == 32) {
-                // Serial.println(" T is 32 ");
-                test = pop();
-            }
-
-            push(p);
-            _CSTORE();
-            p++;
-            // value address c!
+    // n is a byte address in memory.data, not a C pointer: the
+    // string goes in by _CSTORE
+    char str[STRMAX];
+    int ln = 0;
+    for (;;) {
+        int c = parse_char(); // from tib, past the s"
+        if ((c < 0) || (c == '"') || (c == '\r') || (c == '\n')) break;
+        if (ln < STRMAX) str[ln++] = c;
+        else if (ln++ == STRMAX) { // the rest is read, and left out
+            console_out->print(" ERROR INPUT > ");
+            console_out->print(STRMAX);
+            console_out->print("chars +");
         }
-        push(p); _CSTORE();
     }
+    if (ln > STRMAX) ln = STRMAX;
+    int p = n;
+    push(ln); push(p++); _CSTORE();
+    for (int i = ln; i > 0; i--) {
+        push(str[i - 1]); push(p++); _CSTORE(); // value address c!
+    }
+    push(0); push(p); _CSTORE();
     push(n);
-    Serial.print(" "); // subtle ending
-    // return str;
+    console_out->print(" "); // subtle ending
 }
 /*
 
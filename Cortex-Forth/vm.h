@@ -0,0 +1,353 @@
+// vm.h  memory and registers of the Forth virtual machine
+
+#ifndef VM_H
+#define VM_H
+
+/*  memory layout
+
+  memory.data, from cell 0 up, in regions sized per board:
+
+    dictionary     DICT_CELLS     the kernel, then here grows up
+    guard          GUARD_CELLS
+    return stack   RSTACK_CELLS   down from R0
+    guard          GUARD_CELLS
+    data stack     DSTACK_CELLS   down from S0
+    guard          GUARD_CELLS
+    scratch        SCRATCH_CELLS  pad
+
+  The guards are filled with GUARD_FILL at boot, and a MEM_CHECKED
+  build traps when one is written over.  unused is what is left of
+  the dictionary, stack-room what is left of the two stacks.
+
+  BOARD_M4 - the SAMD51's 192 kb, and the host: a 96 kb dictionary.
+  BOARD_M0 - the SAMD21's 32 kb: the layout it always had, R0 at
+  0x0f00 and S0 at 0x1000 in 0x1200 cells.  Define one of them to
+  build for a board other than the one it would pick.
+*/
+
+#if !defined(BOARD_M4) && !defined(BOARD_M0)
+#if defined(__SAMD51__) || defined(HOST_BUILD)
+#define BOARD_M4
+#else
+#define BOARD_M0
+#endif
+#endif
+
+#ifdef BOARD_M4
+#define DICT_CELLS    0x6000
+#define RSTACK_CELLS  0x100
+#define DSTACK_CELLS  0x100
+#define SCRATCH_CELLS 0x400 // 4 kb
+#else // BOARD_M0
+#define DICT_CELLS    0xdfc
+#define RSTACK_CELLS  0x100
+#define DSTACK_CELLS  0xfc
+#define SCRATCH_CELLS 0x1fc
+#endif // #ifdef BOARD_M4
+
+#define GUARD_CELLS 4
+#define GUARD_FILL  0x47554152 // "GUAR"
+
+#define R0 (DICT_CELLS + GUARD_CELLS + RSTACK_CELLS)
+#define S0 (R0 + GUARD_CELLS + DSTACK_CELLS)
+#define PAD (S0 + GUARD_CELLS) // scratch: its first cell
+#define RAM_SIZE (PAD + SCRATCH_CELLS)
+
+// slots in the dictionary index - a power of two, 2 bytes each.  It
+// holds 3/4 as many names; past that, a name not in it is looked for
+// down the links (dict_add ()), and so is every miss, numbers too.
+// An M0's DICT_CELLS hold some 600 short words above the kernel's 110
+#ifdef HOST_BUILD
+#define DICT_SLOTS 2048
+#else
+#define DICT_SLOTS 512 // 1 kb of SRAM: room for 384 names
+#endif // #ifdef HOST_BUILD
+
+/*  cells and primitives
+
+  A code field holds the number of a primitive: its place in
+  kernel.h, where each is given once.  The inner interpreter
+  (vm_run, at the end of Cortex-Forth.ino) switches on that number:
+  a direct call, and the small primitives compile in line, with no
+  call at all.  A cell number also fits in an int on a 64-bit host,
+  where a function pointer would not.
+
+  FN_CELL(a)   function -> cell
+  CELL_FN(c)   cell -> function
+*/
+
+typedef void (*prim_t) (void);
+
+#define CODE(t, p) P##p,
+#define WORD(t, f, s, p) P##p,
+#define PRIM(p) P##p,
+#define CODE_OF(t, p)
+#define WORD_OF(t, f, s, p)
+#define LABEL(t)
+#define DATA(v)
+
+enum { P_NONE = 0, // 0: _THROWN
+#include "kernel.h"
+  PRIM_COUNT };
+
+/*  kernel addresses
+
+  K_t, for each t named in kernel.h: the cell number of that code
+  field or label, as the compiler counts them.  Cell 0 is left
+  empty; KERNEL_H is the first cell past the kernel.
+*/
+
+#define KERNEL_CAT(a, b) a##b
+#define KERNEL_CELL(n) KERNEL_CAT (KD_, n)
+
+#define CODE(t, p) K_##t,
+#define WORD(t, f, s, p) KN_##t, KL_##t, K_##t,
+#define PRIM(p)
+#define CODE_OF(t, p) K_##t,
+#define WORD_OF(t, f, s, p) KN_##t, KL_##t, K_##t,
+#define LABEL(t) K_##t, KE_##t = K_##t - 1,
+#define DATA(v) KERNEL_CELL (__LINE__),
+
+enum { K_NONE = 0,
+#include "kernel.h"
+  KERNEL_H };
+
+extern const prim_t prim_table [PRIM_COUNT];
+extern int prim_cell (prim_t a);
+
+#define FN_CELL(a) (prim_cell (a))
+#define CELL_FN(c) (prim_table [((unsigned int) (c) < PRIM_COUNT) ? (c) : 0]) // 0: _THROWN
+
+/*  names
+
+  The name cell of a word: the length of the name in the low 7
+  bits, a 24 bit hash of it above them (FNV-1a, folded).  The
+  compiler works these out for the kernel (kernel.h); name_key ()
+  in Cortex-Forth.ino, for the names typed in.
+*/
+
+constexpr unsigned int name_fnv (const char *s, int len, unsigned int h) {
+  return len ? name_fnv (s + 1, len - 1, (h ^ (unsigned char) *s) * 16777619u) : h;
+}
+
+constexpr int name_fold (unsigned int h, int len) {
+  return (int) ((((h >> 24) ^ (h & 0xffffff)) << 8) | len);
+}
+
+#define NAME_KEY(s) (name_fold (name_fnv ((s), sizeof (s) - 1, 2166136261u), sizeof (s) - 1))
+
+// number of instructions loop () runs before it returns
+#define VM_BATCH 1024
+
+extern int vm_run (int budget);
+
+/*  addresses
+
+  A Forth address is a byte offset into memory.data: c@ and c!
+  load and store the byte there, and @ and ! the cell at it, which
+  should be aligned (the low two bits are dropped).  here, allot
+  and the body of a variable are in bytes, too.  Inside the
+  machine - I, R, S, code fields and the execution tokens of ' and
+  execute - a cell number is kept, the byte address over 4.
+
+  rbyte reads raw SRAM (a real address, from bottom up): that is
+  the board's memory map, not this one.
+*/
+
+struct Memory {
+  int data [RAM_SIZE];
+};
+
+#define MEM_BYTES ((unsigned char *) memory.data) // byte a is MEM_BYTES [a]
+#define CELL_OF(a) ((a) >> 2)                       // the cell at byte address a
+
+// execute the code field at memory.data [m]
+#define PROGRAM(m) (CELL_FN (memory.data [m]))
+
+extern struct Memory memory;
+
+/*  memory access policy
+
+  Build with MEM_CHECKED (a debug build) and every @ ! c@ c! and
+  dump checks its address against memory.data, rbyte its own
+  against the board's SRAM, and vm_run both stack pointers after
+  each instruction.  One out of range is reported - trap:, what
+  and where - and the machine goes to abort; a store out of range
+  goes to a spare cell, not the dictionary.  Without it, MEM_CELL
+  and MEM_BYTE are the plain array index they always were, and
+  vm_run has no check: the same code as before.
+
+  MEM_CELL(c)  memory.data [c], for a cell number
+  MEM_BYTE(a)  MEM_BYTES [a], for a byte address
+
+  The data stack is task_s0 down to just above S_FLOOR, and the
+  return stack task_r0 down to just above R_FLOOR: the running
+  task's (below), S0 and R0 for the interpreter.  The guards
+  between the regions are checked, too.
+*/
+
+// #if defined(ADAFRUIT_ITSYBITSY_M4_EXPRESS) // per board, or -DMEM_CHECKED
+// #define MEM_CHECKED
+// #endif
+
+#define S_FLOOR (task_cur ? task_r0 : (S0 - DSTACK_CELLS))
+#define R_FLOOR (task_cur ? (task_r0 - TASK_STACK) : (R0 - RSTACK_CELLS))
+
+// SRAM, where rbyte may read
+#define RBYTE_BASE 0x20000000
+#if defined(__SAMD51__) || defined(HOST_BUILD)
+#define RBYTE_SIZE (192 * 1024)
+#else
+#define RBYTE_SIZE (32 * 1024) // SAMD21
+#endif
+
+#ifdef MEM_CHECKED
+extern int mem_trapped;                       // set by mem_trap (): vm_run aborts
+extern void mem_trap (const char *what, int n);
+extern int &mem_cell_out (int c);             // report, and hand back a spare cell
+extern unsigned char &mem_byte_out (int a);
+
+inline int &mem_cell (int c) {
+  return ((unsigned int) c < RAM_SIZE) ? memory.data [c] : mem_cell_out (c);
+}
+
+inline unsigned char &mem_byte (int a) {
+  return ((unsigned int) a < sizeof (memory.data)) ? MEM_BYTES [a] : mem_byte_out (a);
+}
+
+#define MEM_CELL(c) (mem_cell (c))
+#define MEM_BYTE(a) (mem_byte (a))
+#else
+#define MEM_CELL(c) (memory.data [c])
+#define MEM_BYTE(a) (MEM_BYTES [a])
+#endif // #ifdef MEM_CHECKED
+
+/*  profiler
+
+  Built with PROFILE (-DPROFILE, or per board, as MEM_CHECKED
+  above), vm_run tells src/profile.cpp of each instruction it
+  dispatches, and of each colon definition it goes into and out of,
+  while profile-on is in force.  Without it these are nothing, and
+  profile-on and the rest only say so.
+
+  PROF_COUNT(w)    the code field w was executed
+  PROF_NEST(w, r)  into the colon definition w; r is R after the push
+  PROF_EXIT(r)     out of one; r is R before the pop
+  PROF_INITR()     R back to R0
+*/
+
+#ifdef PROFILE
+extern int profiling;
+extern void prof_count (int cfa);
+extern void prof_nest (int cfa, int r);
+extern void prof_exit (int r);
+extern void prof_initr (void);
+
+#define PROF_COUNT(w)   { if (profiling) prof_count (w); }
+#define PROF_NEST(w, r) { if (profiling) prof_nest ((w), (r)); }
+#define PROF_EXIT(r)    { if (profiling) prof_exit (r); }
+#define PROF_INITR()    { if (profiling) prof_initr (); }
+#else
+#define PROF_COUNT(w)
+#define PROF_NEST(w, r)
+#define PROF_EXIT(r)
+#define PROF_INITR()
+#endif // #ifdef PROFILE
+
+/*  trace
+
+  Built with TRACE, vm_run notes I W T S R of each instruction it
+  dispatches in a ring of the last TRACE_SLOTS, before it runs it:
+  five stores and a count, cheap enough to leave in.  .trace lists
+  the ring, and a trap (throw, or one of MEM_CHECKED's) lists it by
+  itself.  When the file interpreter meets a word it does not know
+  (the ~), a copy of the ring is kept, and the next .trace shows
+  that one.
+*/
+
+#ifdef TRACE
+#ifdef HOST_BUILD
+#define TRACE_SLOTS 256
+#else
+#define TRACE_SLOTS 64 // 1280 bytes of SRAM, and as much for the copy
+#endif // #ifdef HOST_BUILD
+
+struct trace_entry {
+  int I, W, T, S, R;
+};
+
+extern struct trace_entry trace_ring [TRACE_SLOTS];
+extern unsigned int trace_n; // instructions noted, ever
+
+#define TRACE_STEP(i, w, t, s, r) { \
+  struct trace_entry *e_ = &trace_ring [trace_n++ & (TRACE_SLOTS - 1)]; \
+  e_->I = (i); e_->W = (w); e_->T = (t); e_->S = (s); e_->R = (r); \
+}
+#else
+#define TRACE_STEP(i, w, t, s, r)
+#endif // #ifdef TRACE
+
+/*  registers
+
+  vm is the state of the machine, and the handle for code
+  outside the inner interpreter: the primitives, and push ()
+  and pop () in dumpram.cpp.  vm_run works on copies held in
+  locals, and writes them back around anything it calls.
+*/
+
+struct VM {
+  int S; // data stack pointer
+  int R; // return stack pointer
+  int I; // instruction pointer
+  int W; // working register
+  int T; // top of stack
+};
+
+extern struct VM vm;
+
+/*  tasks
+
+  A round robin of tasks, each with its own stacks, sharing the
+  dictionary.  The interpreter is the first, the operator: its
+  stacks are S0 and R0.  task makes a word whose body is a task
+  control block - TASK_HEAD cells, then room for a return stack
+  and, above it, a data stack, TASK_STACK cells each.  pause saves
+  S R I T in the running task's block and loads them from the next
+  awake one's; key and parse pause while they wait on the keyboard.
+
+  The first cell of the body is the status: nonzero while the task
+  is awake.  0 t1 ! stops task t1, -1 t1 ! starts it again where
+  it stopped; one that gets to the end of what activate gave it
+  stops.  task_cur is 0 while the operator runs.
+*/
+
+#define TASK_STATUS 0 // awake, or 0: asleep
+#define TASK_LINK   1 // the next task's block, 0: the operator's
+#define TASK_S      2 // the registers, while it is not running
+#define TASK_R      3
+#define TASK_I      4
+#define TASK_T      5
+#define TASK_S0     6 // its stacks
+#define TASK_R0     7
+#define TASK_HEAD   8
+
+#ifdef HOST_BUILD
+#define TASK_STACK 64
+#else
+#define TASK_STACK 32 // cells of each stack: a task is 72 cells
+#endif // #ifdef HOST_BUILD
+
+extern int task_cur;         // the running task's block, 0: the operator's
+extern int task_s0, task_r0; // and its stacks
+
+extern void vm_push (struct VM *v, int n); // dumpram.cpp
+extern int vm_pop (struct VM *v);
+
+extern int H; // dictionary pointer, HERE
+extern int D; // dictionary list entry point
+
+extern void dict_rehash (void); // after D is moved back
+extern void task_forget (int h); // tasks' blocks from h up are gone
+extern void rx_reset (void);     // keyboard input not yet parsed: gone
+
+#endif // #ifndef VM_H